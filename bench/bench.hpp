@@ -0,0 +1,84 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+
+// Minimal benchmark harness shared by the programs of the bench folder.
+// Results are printed as CSV, or as JSON when the program is given --json.
+namespace bench {
+
+    // Prevents the compiler from optimising away a value computed by a benchmark.
+    template<typename T>
+    inline void keep(const T &value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    struct Result {
+        std::string name;
+        long ops;
+        double ns_per_op;
+        double bytes;
+    };
+
+    class Report {
+        private:
+            std::vector<Result> results;
+            bool json;
+
+        public:
+            Report(int argc, const char *argv[]) : json(false) {
+                for(int i=1;i<argc;++i)
+                    if(!strcmp(argv[i],"--json")) json=true;
+            }
+
+            // Runs f (which performs ops_per_call operations) until at least min_ms milliseconds
+            // have elapsed, and records the time per operation.
+            template<typename F>
+            void run(const std::string &name, long ops_per_call, F f, double bytes=0, double min_ms=200) {
+                typedef std::chrono::steady_clock clock;
+                f();
+                long calls=0;
+                double elapsed=0;
+                clock::time_point start=clock::now();
+                while(elapsed<min_ms*1e6) {
+                    f();
+                    ++calls;
+                    elapsed=std::chrono::duration<double,std::nano>(clock::now()-start).count();
+                }
+                long ops=calls*ops_per_call;
+                results.push_back(Result{name,ops,elapsed/ops,bytes});
+            }
+
+            // Records a value that is not a timing (a size, a ratio...).
+            void value(const std::string &name, double bytes) {
+                results.push_back(Result{name,0,0,bytes});
+            }
+
+            void print(std::ostream &out=std::cout) const {
+                if(json) {
+                    out << "[\n";
+                    for(size_t i=0;i<results.size();++i) {
+                        const Result &r=results[i];
+                        out << "  {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+                            << ", \"ns_per_op\": " << r.ns_per_op
+                            << ", \"ops_per_s\": " << (r.ns_per_op>0?1e9/r.ns_per_op:0)
+                            << ", \"bytes\": " << (long long)r.bytes << '}' << (i+1<results.size()?",":"") << '\n';
+                    }
+                    out << "]\n";
+                } else {
+                    out << "name,ops,ns_per_op,ops_per_s,bytes\n";
+                    for(size_t i=0;i<results.size();++i) {
+                        const Result &r=results[i];
+                        out << r.name << ',' << r.ops << ',' << r.ns_per_op << ','
+                            << (r.ns_per_op>0?1e9/r.ns_per_op:0) << ',' << (long long)r.bytes << '\n';
+                    }
+                }
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "bench.hpp"
+#include "libgeometry.h"
+#include "frustum.hpp"
+#include "bvh.hpp"
+#include "ray.hpp"
+#include "object3d.hpp"
+
+using namespace libgeometry;
+
+#define OBJECTS 100000
+#define GRID 300
+#define RAYS 64
+
+float random_float(float min, float max) {
+    return min+(rand()/(float)RAND_MAX)*(max-min);
+}
+
+// Times the build of the hierarchy of OBJECTS boxes on one thread and on all the cores, its refit, and the
+// culling of the boxes through it against the linear culling of every box. Then times the hierarchy of the
+// faces of a GRID x GRID mesh, and the ray queries through it against the test of every face.
+int main(int argc, const char *argv[]) {
+    bench::Report report(argc,argv);
+    srand(42);
+
+    std::vector<AABB<float>> boxes(OBJECTS);
+    for(int i=0;i<OBJECTS;++i) {
+        Vec3r c{random_float(-500,500),random_float(-500,500),random_float(-500,500)};
+        float s=random_float(0.5f,3);
+        boxes[i]=AABB<float>(Vec3r{c[0]-s,c[1]-s,c[2]-s},Vec3r{c[0]+s,c[1]+s,c[2]+s});
+    }
+    // field of vision looking towards -z from the origin
+    Frustum frustum;
+    frustum.update(Mat44r::perspective((80*M_PI)/180,0.5f,100.f));
+
+    BVH<float> bvh;
+    report.run("bvh_build_1_thread",OBJECTS,[&]() { bvh.build(boxes.data(),OBJECTS,1); },0,500);
+    report.run("bvh_build_all_threads",OBJECTS,[&]() { bvh.build(boxes.data(),OBJECTS); },0,500);
+    report.run("bvh_refit",OBJECTS,[&]() { bvh.refit(boxes.data()); });
+    report.value("bvh_nodes",bvh.size());
+
+    Frustum::CullStats stats;
+    std::vector<unsigned char> last_planes(OBJECTS,0);
+    report.run("cull_linear",OBJECTS,[&]() {
+        stats.reset();
+        long visible=0;
+        for(int i=0;i<OBJECTS;++i) {
+            unsigned int mask=Frustum::ALL_PLANES;
+            visible+=frustum.classify(boxes[i],mask,last_planes[i],&stats)!=Frustum::OUTSIDE;
+        }
+        bench::keep(visible);
+    });
+    report.value("plane_tests_linear",stats.plane_tests);
+    std::vector<unsigned char> node_planes(bvh.size(),0);
+    report.run("cull_bvh",OBJECTS,[&]() {
+        stats.reset();
+        long visible=0;
+        bvh.traverse(Frustum::ALL_PLANES,[&](uint32_t node, const AABB<float> &box, unsigned int &mask) {
+            switch(frustum.classify(box,mask,node_planes[node],&stats)) {
+                case Frustum::OUTSIDE: return DISJOINT;
+                case Frustum::INSIDE: return CONTAINED;
+                default: return OVERLAPPING;
+            }
+        },[&](uint32_t) { ++visible; });
+        bench::keep(visible);
+    });
+    report.value("plane_tests_bvh",stats.plane_tests);
+
+    Object3D mesh;
+    for(int i=0;i<GRID;++i)
+        for(int j=0;j<GRID;++j)
+            mesh.add_vertex(i,j,sinf(i*0.1f)*cosf(j*0.1f)*5);
+    for(int i=0;i+1<GRID;++i)
+        for(int j=0;j+1<GRID;++j) {
+            unsigned int v=i*GRID+j;
+            mesh.add_face(v,v+GRID,v+1);
+            mesh.add_face(v+1,v+GRID,v+GRID+1);
+        }
+    std::vector<Ray<float>> rays;
+    for(int i=0;i<RAYS;++i)
+        rays.push_back(Ray<float>(Vec3r{random_float(0,GRID),random_float(0,GRID),20},
+                                  Vec3r{random_float(-1,1),random_float(-1,1),-1}));
+    // the hierarchy is dropped when the faces change, so the rays are first cast without it
+    auto cast=[&]() {
+        long hits=0;
+        for(int i=0;i<RAYS;++i) {
+            float t;
+            unsigned int face;
+            hits+=mesh.raycast(rays[i],t,face);
+        }
+        bench::keep(hits);
+    };
+    report.run("raycast_linear",RAYS,cast,0,50);
+    report.run("face_bvh_build",mesh.num_faces(),[&]() { mesh.build_hierarchy(); },0,500);
+    report.value("face_bvh_nodes",mesh.get_hierarchy().size());
+    report.value("face_bvh_bytes",mesh.get_hierarchy().size()*sizeof(BVH<float>::Node));
+    report.run("raycast_bvh",RAYS,cast);
+    report.print();
+    return 0;
+}
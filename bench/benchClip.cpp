@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "bench.hpp"
+#include "libgeometry.h"
+#include "frustum.hpp"
+
+using namespace libgeometry;
+
+#define BATCH 1024
+
+// Segment clipping as Frustum::inter and LineSegment::inter did it before the outcodes: the planes
+// behind each end are gathered in heap-allocated vectors, and the intersections are checked
+// against the length of the segment with square roots.
+struct LegacyClipper {
+    Plane<float,4> planes[Frustum::PLANE_COUNT];
+
+    static Point<float,4> inter(const LineSegment<float,4> &ls, const Plane<float,4> &p) {
+        Point<float,4> p1=ls.get_begin(),p2=ls.get_end();
+        Direction<float,4> d=p1.length_to(p2);
+        float length=d.norm();
+        if(p.dot(d)==0) return (d.dot(p)!=0)?Point<float,4>():p1;
+        float coef=-(p.dot(p1)/p.dot(d));
+        Point<float,4> res(coef*d+p1);
+        if(p1.length_to(res).norm()<=length&&p2.length_to(res).norm()<=length)
+            return res;
+        return Point<float,4>();
+    }
+
+    std::vector<Plane<float,4>> get_planes_behind(const Valid<Point<float,4>> &p) const {
+        std::vector<Plane<float,4>> v;
+        for(int i=0;i<Frustum::PLANE_COUNT;++i)
+            if(p.behind(planes[i])) v.push_back(planes[i]);
+        return v;
+    }
+
+    LineSegment<float,4> clip(const LineSegment<float,4> &ls) const {
+        Valid<Point<float,4>> b(ls.get_begin()), e(ls.get_end());
+        Point<float,4> p;
+        std::vector<Plane<float,4>> planes_b=get_planes_behind(b),planes_e=get_planes_behind(e);
+        if(planes_b.size()==0&&planes_e.size()==0) return ls;
+        if(planes_b.size()==0)
+            for(size_t i=0;i<planes_e.size();++i)
+                if(!(p=inter(ls,planes_e[i])).is_null()) return LineSegment<float,4>(b,p);
+        if(planes_e.size()==0)
+            for(size_t i=0;i<planes_b.size();++i)
+                if(!(p=inter(ls,planes_b[i])).is_null()) return LineSegment<float,4>(e,p);
+        Point<float,4> ls2[2];
+        int cpt=0;
+        std::vector<Plane<float,4>> unique_plans=planes_b;
+        for(size_t i=0;i<planes_e.size();++i) {
+            bool present=false;
+            for(size_t j=0;j<planes_b.size();++j)
+                if(planes_e[i]==planes_b[j]) present=true;
+            if(!present) unique_plans.push_back(planes_e[i]);
+        }
+        for(size_t i=0;i<unique_plans.size();++i) {
+            ls2[cpt]=inter(ls,unique_plans[i]);
+            if(!ls2[cpt].is_null()&&++cpt==2)
+                return LineSegment<float,4>(ls2[0],ls2[1]);
+        }
+        return LineSegment<float,4>();
+    }
+};
+
+float random_float(float min, float max) {
+    return min+(rand()/(float)RAND_MAX)*(max-min);
+}
+
+// Returns a view space point at most depth units in front of the camera, with x and y in [-width,width].
+Point<float,4> random_point(float width, float depth) {
+    return Point<float,4>{random_float(-width,width),random_float(-width,width),random_float(-depth,-1)};
+}
+
+// Compares the segment clipping of Frustum::inter with the former one, on view space segments in
+// front of the camera, a part of them crossing the sides of the field of vision, and with the
+// clipping in homogeneous clip space of the same segments.
+int main(int argc, const char *argv[]) {
+    bench::Report report(argc,argv);
+    srand(42);
+
+    Frustum frustum(100.f,0.5f,4.f/3);
+    frustum.update((80*M_PI)/180);
+    LegacyClipper legacy;
+    for(int i=0;i<Frustum::PLANE_COUNT;++i)
+        legacy.planes[i]=frustum.get_plane(i);
+
+    Transform<float> proj(Mat44r::perspective((80*M_PI)/180,0.5f,100.f));
+    static LineSegment<float,4> inside[BATCH],crossing[BATCH],projected[BATCH];
+    for(int i=0;i<BATCH;++i) {
+        Point<float,4> p1=random_point(0.5f,50),p2=random_point(0.5f,50);
+        p1[2]-=1; p2[2]-=1;
+        inside[i]=LineSegment<float,4>(p1,p2);
+        crossing[i]=LineSegment<float,4>(random_point(30,40),random_point(30,40));
+        projected[i]=LineSegment<float,4>(proj.apply(crossing[i].get_begin()),proj.apply(crossing[i].get_end()));
+    }
+
+    report.run("clip_inside_legacy",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            LineSegment<float,4> ls=legacy.clip(inside[i]);
+            bench::keep(ls);
+        }
+    });
+    report.run("clip_inside_outcode",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            LineSegment<float,4> ls=frustum.inter(inside[i]);
+            bench::keep(ls);
+        }
+    });
+    report.run("clip_crossing_legacy",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            LineSegment<float,4> ls=legacy.clip(crossing[i]);
+            bench::keep(ls);
+        }
+    });
+    report.run("clip_crossing_outcode",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            LineSegment<float,4> ls=frustum.inter(crossing[i]);
+            bench::keep(ls);
+        }
+    });
+    report.run("clip_crossing_clip_space",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            LineSegment<float,4> ls=Frustum::clip_homogeneous(projected[i]);
+            bench::keep(ls);
+        }
+    });
+    report.print();
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "bench.hpp"
+#include "libgeometry.h"
+#include "frustum.hpp"
+
+using namespace libgeometry;
+
+#define OBJECTS 65536
+
+float random_float(float min, float max) {
+    return min+(rand()/(float)RAND_MAX)*(max-min);
+}
+
+// Compares the culling of OBJECTS bounding spheres one at a time with Frustum::outside, and in
+// one batch with Frustum::visible_spheres at every SIMD level, as well as the batch culling of boxes
+// and the culling testing first the plane that rejected each sphere in the previous frame.
+int main(int argc, const char *argv[]) {
+    bench::Report report(argc,argv);
+    srand(42);
+
+    Frustum frustum(100.f,0.5f,4.f/3);
+    frustum.update((80*M_PI)/180);
+
+    std::vector<Sphere<float,4>> spheres(OBJECTS);
+    std::vector<float> x(OBJECTS),y(OBJECTS),z(OBJECTS),r(OBJECTS),ex(OBJECTS),ey(OBJECTS),ez(OBJECTS);
+    std::vector<uint32_t> visible((OBJECTS+31)/32);
+    for(int i=0;i<OBJECTS;++i) {
+        x[i]=random_float(-100,100);
+        y[i]=random_float(-100,100);
+        z[i]=random_float(-120,20);
+        r[i]=random_float(0.1f,5);
+        ex[i]=ey[i]=ez[i]=r[i];
+        spheres[i]=Sphere<float,4>(Point<float,4>{x[i],y[i],z[i]},r[i]);
+    }
+    double bytes=OBJECTS*4*sizeof(float);
+
+    report.run("cull_spheres_one_by_one",OBJECTS,[&]() {
+        for(int i=0;i<OBJECTS;++i)
+            if(frustum.outside(spheres[i])) visible[i/32]&=~(1u<<(i%32));
+            else visible[i/32]|=1u<<(i%32);
+        bench::keep(visible[0]);
+    });
+    const char *names[]={"cull_spheres_scalar","cull_spheres_sse2","cull_spheres_avx"};
+    simd::Level best=simd::supported();
+    for(int l=simd::SCALAR;l<=best;++l) {
+        simd::set_level((simd::Level)l);
+        report.run(names[l],OBJECTS,[&]() {
+            frustum.visible_spheres(x.data(),y.data(),z.data(),r.data(),OBJECTS,visible.data());
+            bench::keep(visible[0]);
+        },bytes);
+    }
+    report.run("cull_boxes",OBJECTS,[&]() {
+        frustum.visible_boxes(x.data(),y.data(),z.data(),ex.data(),ey.data(),ez.data(),OBJECTS,visible.data());
+        bench::keep(visible[0]);
+    },bytes*6/4);
+    // Objects do not move between two frames: the plane that rejected them is tested first.
+    std::vector<unsigned char> last_planes(OBJECTS,0);
+    Frustum::CullStats stats;
+    report.run("cull_spheres_fixed_order",OBJECTS,[&]() {
+        stats.reset();
+        for(int i=0;i<OBJECTS;++i) {
+            unsigned int mask=Frustum::ALL_PLANES;
+            unsigned char last=0;
+            bench::keep(frustum.classify(spheres[i],mask,last,&stats));
+        }
+    });
+    report.value("plane_tests_per_object_x100_fixed_order",stats.average()*100);
+    report.run("cull_spheres_coherent",OBJECTS,[&]() {
+        stats.reset();
+        for(int i=0;i<OBJECTS;++i) {
+            unsigned int mask=Frustum::ALL_PLANES;
+            bench::keep(frustum.classify(spheres[i],mask,last_planes[i],&stats));
+        }
+    });
+    report.value("plane_tests_per_object_x100_coherent",stats.average()*100);
+    report.print();
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "bench.hpp"
+#include "libgeometry.h"
+
+using namespace libgeometry;
+
+#define BATCH 1000
+
+// Compares the generic Gauss-Jordan inverse with the closed-form inverses,
+// on the kind of matrix Camera::update inverts every frame.
+int main(int argc, const char *argv[]) {
+    bench::Report report(argc,argv);
+    Transform<float> views[BATCH];
+    for(int i=0;i<BATCH;++i) {
+        Transform<float> rotation(Quaternion<float>(i*0.36f,Direction<float,4>{0.f,1.f,0.f}));
+        views[i]=Transform<float>(Vec3r{i*0.01f,-1.f,2.f}).concat(rotation);
+    }
+
+    report.run("inverse_gauss_jordan",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Mat44r inv=views[i].getM().inverse();
+            bench::keep(inv);
+        }
+    });
+    report.run("inverse_cofactor",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Mat44r inv=views[i].getM().inverse_cofactor();
+            bench::keep(inv);
+        }
+    });
+    report.run("inverse_affine",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Mat44r inv=views[i].getM().inverse_affine();
+            bench::keep(inv);
+        }
+    });
+    report.run("inverse_rigid",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Mat44r inv=views[i].getM().inverse_rigid();
+            bench::keep(inv);
+        }
+    });
+    report.run("transform_inverse",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Transform<float> inv=views[i].inverse();
+            bench::keep(inv);
+        }
+    });
+    report.print();
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <math.h>
+#include "bench.hpp"
+#include "libgeometry.h"
+#include "frustum.hpp"
+
+using namespace libgeometry;
+
+#define BATCH 1024
+
+float random_float(float min, float max) {
+    return min+(rand()/(float)RAND_MAX)*(max-min);
+}
+
+Point<float,4> random_point(float min, float max) {
+    return Point<float,4>{random_float(min,max),random_float(min,max),random_float(min,max)};
+}
+
+Direction<float,4> random_axis() {
+    return Direction<float,4>{random_float(-1,1),random_float(-1,1),random_float(-1,1)}.to_unit();
+}
+
+// Times the libmatrix and libgeometry operations used every frame, over batches of BATCH values
+// similar to the ones of a scene: model-view-projection transforms, vertices a few units around
+// the camera, and edges partly inside the field of vision.
+int main(int argc, const char *argv[]) {
+    bench::Report report(argc,argv);
+    srand(42);
+
+    Frustum frustum(100.f,0.5f,4.f/3);
+    frustum.update((80*M_PI)/180);
+    Mat44r proj=Mat44r::perspective((80*M_PI)/180,0.5f,100.f);
+
+    static Transform<float> transforms[BATCH];
+    static Mat44r matrices[BATCH];
+    static Quaternion<float> quats[BATCH];
+    static Point<float,4> points[BATCH];
+    static Triangle<float,4> triangles[BATCH];
+    static Sphere<float,4> spheres[BATCH];
+    static LineSegment<float,4> segments[BATCH];
+    for(int i=0;i<BATCH;++i) {
+        Transform<float> model=Transform<float>(Vec3r{random_float(-5,5),random_float(-5,5),random_float(-5,5)})
+                               .concat(Transform<float>(random_float(0,360),random_axis()));
+        transforms[i]=model.concat(Transform<float>(proj));
+        matrices[i]=model.getM();
+        quats[i]=Quaternion<float>(random_float(0,360),random_axis());
+        points[i]=random_point(-10,10);
+        triangles[i]=Triangle<float,4>(random_point(-10,10),random_point(-10,10),random_point(-10,10));
+        spheres[i]=Sphere<float,4>(random_point(-50,50),random_float(0.1f,5));
+        segments[i]=LineSegment<float,4>(random_point(-20,20),random_point(-20,20));
+    }
+
+    report.run("matrix_multiply",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Mat44r m=matrices[i]*matrices[(i+1)%BATCH];
+            bench::keep(m);
+        }
+    });
+    report.run("matrix_inverse",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Mat44r m=matrices[i].inverse();
+            bench::keep(m);
+        }
+    });
+    report.run("transform_inverse",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Transform<float> t=transforms[i].inverse();
+            bench::keep(t);
+        }
+    });
+    report.run("transform_apply",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Point<float,4> p=transforms[i].apply(points[i]);
+            bench::keep(p);
+        }
+    });
+    report.run("transform_apply_many",BATCH,[&]() {
+        static Point<float,4> out[BATCH];
+        transforms[0].apply_many(points[0].data(),out[0].data(),BATCH);
+        bench::keep(out);
+    },BATCH*2*sizeof(Point<float,4>));
+    report.run("quaternion_multiply",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Quaternion<float> q=quats[i]*quats[(i+1)%BATCH];
+            bench::keep(q);
+        }
+    });
+    report.run("quaternion_normalize",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Vec4r q=quats[i].to_unit();
+            bench::keep(q);
+        }
+    });
+    report.run("triangle_normale",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            Direction<float,4> n=triangles[i].normale();
+            bench::keep(n);
+        }
+    });
+    report.run("frustum_outside_point",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            bool out=frustum.outside(points[i]);
+            bench::keep(out);
+        }
+    });
+    report.run("frustum_outside_sphere",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            bool out=frustum.outside(spheres[i]);
+            bench::keep(out);
+        }
+    });
+    report.run("frustum_inter",BATCH,[&]() {
+        for(int i=0;i<BATCH;++i) {
+            LineSegment<float,4> ls=frustum.inter(segments[i]);
+            bench::keep(ls);
+        }
+    });
+    report.print();
+    return 0;
+}
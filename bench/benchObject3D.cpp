@@ -0,0 +1,207 @@
+#include <vector>
+#include "bench.hpp"
+#include "libgeometry.h"
+#include "object3d.hpp"
+
+using namespace libgeometry;
+
+#define GRID 300
+
+// Layout of Point<float,4> and Triangle<float,4> when Vector::at was virtual,
+// kept to measure what the plain value types save.
+struct LegacyPoint {
+    float array[4];
+    virtual float at(int i) const { return array[i]; }
+    virtual ~LegacyPoint() {}
+};
+
+struct LegacyTriangle {
+    LegacyPoint p0,p1,p2;
+    float a;
+};
+
+// Builds a GRID x GRID grid of vertices, with two faces per cell.
+void build_grid(Object3D &o, std::vector<LegacyPoint> &lv, std::vector<LegacyTriangle> &lf) {
+    for(int i=0;i<GRID;++i)
+        for(int j=0;j<GRID;++j) {
+            o.add_vertex(i,j,0);
+            LegacyPoint p;
+            p.array[0]=i; p.array[1]=j; p.array[2]=0; p.array[3]=1;
+            lv.push_back(p);
+        }
+    for(int i=0;i+1<GRID;++i)
+        for(int j=0;j+1<GRID;++j) {
+            unsigned int v=i*GRID+j;
+            o.add_face(v,v+1,v+GRID);
+            o.add_face(v+1,v+GRID+1,v+GRID);
+            lf.push_back(LegacyTriangle{lv[v],lv[v+1],lv[v+GRID],0});
+            lf.push_back(LegacyTriangle{lv[v+1],lv[v+GRID+1],lv[v+GRID],0});
+        }
+}
+
+// Builds a smooth torus of n x n vertices around the z axis, with two faces per cell.
+void build_torus(Object3D &o, int n) {
+    for(int i=0;i<n;++i)
+        for(int j=0;j<n;++j) {
+            float u=2*M_PI*i/n,v=2*M_PI*j/n,r=3+cosf(v);
+            o.add_vertex(r*cosf(u),r*sinf(u),sinf(v));
+        }
+    for(int i=0;i<n;++i)
+        for(int j=0;j<n;++j) {
+            unsigned int v=i*n+j,right=((i+1)%n)*n+j,up=i*n+(j+1)%n,diag=((i+1)%n)*n+(j+1)%n;
+            o.add_face(v,right,up);
+            o.add_face(up,right,diag);
+        }
+}
+
+// Backface test of a transformed face as Camera::sees made it, against the direction of the default camera moved
+// by its position, kept to measure what the planes of the faces save.
+bool legacy_sees(const Point<float,4> &position, Triangle<float,4> &t) {
+    if(t.is_null()) return false;
+    Direction<float,4> test{position.x(),position.y(),1};
+    Vector<float,4> v1(t.get_p1()-t.get_p0()),v2(t.get_p2()-t.get_p0());
+    return test.dot(Direction<float,4>(v1.cross(v2).to_unit()))>0;
+}
+
+// Bounding sphere of the vertices centered on the position of the object, computed on every call as
+// Object3D::bsphere was, kept to measure what the cached Ritter sphere saves.
+Sphere<float,4> legacy_bsphere(const Object3D &o, const std::vector<LegacyPoint> &lv) {
+    Point<float,4> position=o.get_position();
+    float max=0;
+    for(size_t i=0;i<lv.size();++i) {
+        float dx=lv[i].at(0)-position.x(),dy=lv[i].at(1)-position.y(),dz=lv[i].at(2)-position.z();
+        float tmp=sqrtf(dx*dx+dy*dy+dz*dz);
+        if(tmp>max) max=tmp;
+    }
+    return Sphere<float,4>(position,max);
+}
+
+int main(int argc, const char *argv[]) {
+    bench::Report report(argc,argv);
+    Object3D o;
+    std::vector<LegacyPoint> lv;
+    std::vector<LegacyTriangle> lf;
+    build_grid(o,lv,lf);
+    long nv=lv.size(),nf=lf.size();
+
+    report.value("sizeof_point",sizeof(Point<float,4>));
+    report.value("sizeof_point_legacy",sizeof(LegacyPoint));
+    report.value("sizeof_triangle",sizeof(Triangle<float,4>));
+    report.value("sizeof_triangle_legacy",sizeof(LegacyTriangle));
+    double bytes=o.mesh_bytes();
+    double triangle_bytes=nv*sizeof(Point<float,4>)+nf*sizeof(Triangle<float,4>);
+    double legacy_bytes=nv*sizeof(LegacyPoint)+nf*sizeof(LegacyTriangle);
+    report.value("mesh_bytes",bytes);
+    report.value("mesh_bytes_triangles",triangle_bytes);
+    report.value("mesh_bytes_legacy",legacy_bytes);
+
+    report.run("copy_object3d",nv+nf,[&]() {
+        Object3D copy=o;
+        bench::keep(copy);
+    },bytes);
+    report.run("copy_mesh_legacy",nv+nf,[&]() {
+        std::vector<LegacyPoint> v=lv;
+        std::vector<LegacyTriangle> f=lf;
+        bench::keep(v);
+        bench::keep(f);
+    },legacy_bytes);
+    // transform of the vertices of a frame: once per corner of every face as when the faces held their points,
+    // and once per vertex into the post-transform cache
+    Transform<float> mvp=Transform<float>(Mat44r::perspective(1.4f,0.5f,100.f)).concat(o.getTransform());
+    std::vector<Point<float,4>> buffer(3*nf);
+    report.run("transform_per_corner",nf,[&]() {
+        for(long i=0;i<nf;++i) {
+            Triangle<float,4> t=o.face(i);
+            buffer[3*i]=t.get_p0();
+            buffer[3*i+1]=t.get_p1();
+            buffer[3*i+2]=t.get_p2();
+        }
+        mvp.apply_many(buffer[0].data(),buffer[0].data(),3*nf);
+        bench::keep(buffer);
+    });
+    report.run("transform_per_vertex",nf,[&]() {
+        mvp.apply_many(o.get_coords(0),o.get_coords(1),o.get_coords(2),buffer[0].data(),nv);
+        bench::keep(buffer);
+    },nv*(3+4)*sizeof(float));
+    // same, from vertices stored as points (with their w) as before the coordinates were split by axis
+    std::vector<Point<float,4>> points(nv);
+    for(long i=0;i<nv;++i)
+        points[i]=o.vertex(i);
+    report.run("transform_per_vertex_points",nf,[&]() {
+        mvp.apply_many(points[0].data(),buffer[0].data(),nv);
+        bench::keep(buffer);
+    },nv*(4+4)*sizeof(float));
+    // backface test of every face: normale of the transformed triangle as Camera::sees computed it, and plane of
+    // the face against the camera in object space
+    Point<float,4> camera_position{0,0,-1};
+    Point<float,4> eye=o.getAffine().inverse().apply(Point<float,4>{150,150,50});
+    Vector<float,3> eye3{eye.x(),eye.y(),eye.z()};
+    for(long i=0;i<nf;++i)
+        for(int k=0;k<3;++k)
+            buffer[3*i+k]=mvp.apply(o.vertex(o.index(i,k)));
+    report.run("backface_transformed_normale",nf,[&]() {
+        long front=0;
+        for(long i=0;i<nf;++i) {
+            Triangle<float,4> t(buffer[3*i],buffer[3*i+1],buffer[3*i+2]);
+            front+=legacy_sees(camera_position,t);
+        }
+        bench::keep(front);
+    });
+    report.run("backface_plane",nf,[&]() {
+        long front=0;
+        for(long i=0;i<nf;++i)
+            front+=o.faces(i,eye3);
+        bench::keep(front);
+    });
+    // lines drawn for the faces facing the camera: three per face, and once per edge with the table of the edges
+    std::vector<uint32_t> front;
+    for(long i=0;i<nf;++i)
+        if(o.faces(i,eye3)) front.push_back(i);
+    report.run("build_edges",nf,[&]() { o.build_edges(); },0,500);
+    std::vector<unsigned char> flags;
+    long lines=0;
+    report.run("visit_edges",front.size(),[&]() {
+        lines=0;
+        o.visit_edges(front.data(),front.size(),flags,[&](uint32_t, uint32_t) { ++lines; });
+        bench::keep(lines);
+    });
+    report.value("lines_per_frame_faces",3*front.size());
+    report.value("lines_per_frame_edges",lines);
+    report.value("mesh_bytes_with_edges",o.mesh_bytes());
+    // lines drawn for a smooth mesh with the edges of the faces facing the camera, and with its feature edges only
+    Object3D torus;
+    build_torus(torus,512);
+    torus.build_creases(30);
+    Vec3r eye_torus{10,0,10};
+    std::vector<uint32_t> torus_front,features;
+    for(uint32_t i=0;i<torus.num_faces();++i)
+        if(torus.faces(i,eye_torus)) torus_front.push_back(i);
+    long torus_lines=0;
+    torus.visit_edges(torus_front.data(),torus_front.size(),flags,[&](uint32_t, uint32_t) { ++torus_lines; });
+    long ne=torus.get_edges().size();
+    report.run("feature_edges_1_thread",ne,[&]() {
+        torus.feature_edges(eye_torus,features,1);
+        bench::keep(features);
+    });
+    report.run("feature_edges_all_threads",ne,[&]() {
+        torus.feature_edges(eye_torus,features);
+        bench::keep(features);
+    });
+    report.value("lines_per_frame_torus_edges",torus_lines);
+    report.value("lines_per_frame_torus_features",features.size());
+    report.run("bsphere_cached",1,[&]() {
+        Sphere<float,4> s=o.bsphere();
+        bench::keep(s);
+    });
+    report.run("bsphere_legacy",1,[&]() {
+        Sphere<float,4> s=legacy_bsphere(o,lv);
+        bench::keep(s);
+    });
+    report.run("fit_bounds",nv,[&]() { o.fit_bounds(); });
+    // radius relative to the half diagonal of the box: 1 for the sphere circumscribing the box
+    Vector<float,3> e=o.bbox().extents();
+    report.value("bsphere_radius_ratio",o.bsphere().getRadius()/sqrtf(e.dot(e)));
+    report.value("bsphere_radius_ratio_legacy",legacy_bsphere(o,lv).getRadius()/sqrtf(e.dot(e)));
+    report.print();
+    return 0;
+}
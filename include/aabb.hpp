@@ -0,0 +1,81 @@
+#ifndef AABB_HPP
+#define AABB_HPP
+
+#include <iostream>
+#include <limits>
+#include "libmatrix.h"
+
+namespace libgeometry {
+    using namespace libmatrix;
+
+    // Axis-aligned box given by its lowest and highest corners. The default box is empty (its corners
+    // are +infinity and -infinity), so that it can be grown from nothing.
+    template<typename T>
+    class AABB {
+        private:
+            Vector<T,3> low,high;
+
+        public:
+            AABB() {
+                T inf=std::numeric_limits<T>::infinity();
+                low=Vector<T,3>{inf,inf,inf};
+                high=Vector<T,3>{-inf,-inf,-inf};
+            }
+
+            AABB(const Vector<T,3> &_low, const Vector<T,3> &_high) : low(_low), high(_high) {}
+
+            inline const Vector<T,3> &get_low() const { return low; }
+            inline const Vector<T,3> &get_high() const { return high; }
+
+            // Returns true if the box contains no point.
+            bool is_empty() const { return low[0]>high[0]||low[1]>high[1]||low[2]>high[2]; }
+
+            // Grows the box so that it contains the point given as argument.
+            void grow(const Vector<T,3> &p) {
+                for(int i=0;i<3;++i) {
+                    if(p[i]<low[i]) low[i]=p[i];
+                    if(p[i]>high[i]) high[i]=p[i];
+                }
+            }
+
+            // Grows the box so that it contains the box given as argument.
+            void grow(const AABB<T> &b) {
+                for(int i=0;i<3;++i) {
+                    if(b.low[i]<low[i]) low[i]=b.low[i];
+                    if(b.high[i]>high[i]) high[i]=b.high[i];
+                }
+            }
+
+            // Returns true if the box given as argument is inside this one.
+            bool contains(const AABB<T> &b) const {
+                for(int i=0;i<3;++i)
+                    if(b.low[i]<low[i]||b.high[i]>high[i]) return false;
+                return true;
+            }
+
+            // Returns the center of the box.
+            Vector<T,3> center() const {
+                return Vector<T,3>{(low[0]+high[0])/2,(low[1]+high[1])/2,(low[2]+high[2])/2};
+            }
+
+            // Returns the half sizes of the box along each axis.
+            Vector<T,3> extents() const {
+                return Vector<T,3>{(high[0]-low[0])/2,(high[1]-low[1])/2,(high[2]-low[2])/2};
+            }
+
+            // Returns the area of the surface of the box (0 if it is empty).
+            T surface_area() const {
+                if(is_empty()) return 0;
+                T dx=high[0]-low[0],dy=high[1]-low[1],dz=high[2]-low[2];
+                return 2*(dx*dy+dy*dz+dz*dx);
+            }
+    };
+
+    template<typename T>
+    std::ostream &operator <<(std::ostream &out, const AABB<T> &b) {
+        out << '(' << b.get_low() << ',' << b.get_high() << ')';
+        return out;
+    }
+}
+
+#endif
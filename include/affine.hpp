@@ -0,0 +1,144 @@
+#ifndef AFFINE_HPP
+#define AFFINE_HPP
+
+#include <iostream>
+#include "matrix.hpp"
+#include "quaternion.hpp"
+#include "point.hpp"
+#include "direction.hpp"
+#include "aabb.hpp"
+#include "transform.hpp"
+
+namespace libgeometry {
+
+    // Affine transform stored as the 3 first rows of its 4x4 matrix, the last one being 0 0 0 1.
+    // Model and view transforms are affine: applying and concatenating them this way skips the
+    // constant row, a quarter of the work of Transform. Points are transformed with w=1 and
+    // directions with w=0.
+    template<typename T>
+    class Affine3 {
+        private:
+            Matrix<T,3,4> m;
+            TransformKind kind;
+
+            // Returns the 3 first rows of a 4x4 matrix.
+            static constexpr Matrix<T,3,4> top(const Matrix<T,4,4> &m4) {
+                Matrix<T,3,4> res(uninit);
+                for(int i=0;i<3;++i)
+                    res[i]=m4[i];
+                return res;
+            }
+
+        public:
+            constexpr Affine3() : kind(AFFINE) {}
+
+            constexpr explicit Affine3(const Matrix<T,3,4> &_m) : m(_m), kind(AFFINE) {}
+
+            // Builds a transform whose kind is already known (RIGID or AFFINE).
+            constexpr Affine3(const Matrix<T,3,4> &_m, TransformKind k) : m(_m), kind(k) {}
+
+            // Keeps the 3 first rows of the transform given as argument, which must be affine.
+            constexpr explicit Affine3(const Transform<T> &t) : m(top(t.getM())), kind((t.getKind()==RIGID)?RIGID:AFFINE) {}
+
+            constexpr Affine3(Quaternion<T> q) : Affine3(Transform<T>(q)) {}
+
+            constexpr Affine3(float angle,const Direction<T,4> &axis) : Affine3(Transform<T>(angle,axis)) {}
+
+            constexpr Affine3(Vector<T,3> v, bool scale=false) : Affine3(Transform<T>(v,scale)) {}
+
+            // Returns the identity transform.
+            static constexpr Affine3<T> identity() {
+                return Affine3<T>(top(Matrix<T,4,4>::identity()),RIGID);
+            }
+
+            // Returns the concatenation of two transforms (this one, then the one given as argument).
+            constexpr Affine3<T> concat(const Affine3<T> &tr) const {
+                Matrix<T,3,4> res(uninit);
+                for(int i=0;i<3;++i) {
+                    res[i]=m[0]*tr.m[i][0]+m[1]*tr.m[i][1]+m[2]*tr.m[i][2];
+                    res[i][3]+=tr.m[i][3];
+                }
+                return Affine3<T>(res,(kind>tr.kind)?kind:tr.kind);
+            }
+
+            // Returns the 4x4 matrix of this transform followed by the projection given as argument.
+            constexpr Matrix<T,4,4> project(const Matrix<T,4,4> &proj) const {
+                Matrix<T,4,4> res(uninit);
+                for(int i=0;i<4;++i) {
+                    res[i]=m[0]*proj[i][0]+m[1]*proj[i][1]+m[2]*proj[i][2];
+                    res[i][3]+=proj[i][3];
+                }
+                return res;
+            }
+
+            // Returns the inverse transform. Returns a transform with a null matrix if it is not invertible.
+            constexpr Affine3<T> inverse() const {
+                Matrix<T,4,4> m4=to_matrix();
+                return Affine3<T>(top((kind==RIGID)?m4.inverse_rigid():m4.inverse_affine()),kind);
+            }
+
+            // Returns a new point corresponding to the transform applied to the point given as argument.
+            constexpr Point<T,4> apply(const Point<T,4> &p) const {
+                if(p.is_null()) return Point<T,4>();
+                Point<T,4> res(uninit);
+                for(int i=0;i<3;++i)
+                    res[i]=((m[i][0]*p.x()+m[i][1]*p.y())+m[i][2]*p.z())+m[i][3];
+                res.w()=1;
+                return res;
+            }
+
+            // Returns a new direction corresponding to the transform applied to the direction given as argument.
+            constexpr Direction<T,4> apply(const Direction<T,4> &d) const {
+                if(d.is_null()) return Direction<T,4>();
+                Direction<T,4> res(uninit);
+                for(int i=0;i<3;++i)
+                    res[i]=(m[i][0]*d.x()+m[i][1]*d.y())+m[i][2]*d.z();
+                res.w()=0;
+                return res;
+            }
+
+            // Returns the smallest axis-aligned box containing the transform of the box given as argument.
+            AABB<T> apply(const AABB<T> &b) const {
+                if(b.is_empty()) return b;
+                Vector<T,3> c=b.center(),e=b.extents(),low(uninit),high(uninit);
+                for(int i=0;i<3;++i) {
+                    T center=((m[i][0]*c[0]+m[i][1]*c[1])+m[i][2]*c[2])+m[i][3];
+                    T radius=(fabs(m[i][0])*e[0]+fabs(m[i][1])*e[1])+fabs(m[i][2])*e[2];
+                    low[i]=center-radius;
+                    high[i]=center+radius;
+                }
+                return AABB<T>(low,high);
+            }
+
+            // Applies the transform to n points stored one after the other in in (4 coordinates each, as in
+            // a contiguous array of Point<T,4>), and stores the results the same way in out, which can be in.
+            // The points must be valid, and their w is taken as 1.
+            void apply_many(const T *in, T *out, size_t n) const {
+                const T *rows[3]={m[0].data(),m[1].data(),m[2].data()};
+                simd::Kernels<T,4>::transform_affine(rows,in,out,n);
+            }
+
+            // Returns the 4x4 matrix of the transform.
+            constexpr Matrix<T,4,4> to_matrix() const {
+                Matrix<T,4,4> res(uninit);
+                for(int i=0;i<3;++i)
+                    res[i]=m[i];
+                res[3]=Vector<T,4>{0,0,0,1};
+                return res;
+            }
+
+            // Returns the kind of the transform (RIGID or AFFINE).
+            constexpr TransformKind getKind() const { return kind; }
+
+            // Returns the 3x4 matrix of the transform.
+            constexpr Matrix<T,3,4> getM() const { return m; }
+    };
+
+    template<typename T>
+    std::ostream &operator <<(std::ostream &out, const Affine3<T> &a) {
+        out << a.getM();
+        return out;
+    }
+}
+
+#endif
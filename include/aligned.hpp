@@ -0,0 +1,45 @@
+#ifndef ALIGNED_HPP
+#define ALIGNED_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace libmatrix {
+
+    // Allocator of arrays aligned on A bytes (a cache line by default), so that the SIMD loops over them start
+    // on a boundary and never split a load across two lines.
+    template<typename T, size_t A=64>
+    struct AlignedAllocator {
+        typedef T value_type;
+
+        // A is not a type, so std::allocator_traits cannot rebind the allocator by itself.
+        template<typename U>
+        struct rebind { typedef AlignedAllocator<U,A> other; };
+
+        AlignedAllocator() {}
+
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U,A> &) {}
+
+        T *allocate(size_t n) {
+            return static_cast<T *>(::operator new(n*sizeof(T),std::align_val_t(A)));
+        }
+
+        void deallocate(T *p, size_t) {
+            ::operator delete(p,std::align_val_t(A));
+        }
+
+        template<typename U>
+        bool operator==(const AlignedAllocator<U,A> &) const { return true; }
+
+        template<typename U>
+        bool operator!=(const AlignedAllocator<U,A> &) const { return false; }
+    };
+
+    // Vector whose elements start on an A-byte boundary.
+    template<typename T, size_t A=64>
+    using aligned_vector=std::vector<T,AlignedAllocator<T,A>>;
+}
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include "aabb.hpp"
+
+namespace libgeometry {
+
+    // Position of a node of a hierarchy relative to the volume it is tested against during a traversal.
+    enum Overlap { DISJOINT, OVERLAPPING, CONTAINED };
+
+    // Bounding volume hierarchy over primitives known by their boxes (objects of a scene, faces of a mesh...),
+    // which are referred to by their index. It is built top-down with the surface area heuristic evaluated on
+    // bins, the subtrees of large ranges being built on several threads. When the primitives move, refit updates
+    // the boxes of the nodes without changing the tree.
+    template<typename T>
+    class BVH {
+        public:
+            // Node of the hierarchy. A leaf holds the count primitives starting at offset in the primitive order;
+            // an inner node (count==0) holds the index of its first child, the second one being just after it.
+            struct Node {
+                AABB<T> box;
+                uint32_t offset;
+                uint32_t count;
+
+                inline bool is_leaf() const { return count!=0; }
+            };
+
+        private:
+            static const int BINS=16;
+            static const uint32_t MAX_LEAF_SIZE=8;
+            static const uint32_t MIN_PARALLEL_SIZE=4096; // ranges smaller than this are built on a single thread
+
+            std::vector<Node> nodes;
+            std::vector<uint32_t> order; // indices of the primitives, in the order of the leaves
+
+            // Builds the subtree of the given node over the primitives order[first..first+count), on threads threads.
+            void build_node(uint32_t node, uint32_t first, uint32_t count, const AABB<T> *boxes,
+                            const Vector<T,3> *centers, std::atomic<uint32_t> &next, unsigned int threads) {
+                AABB<T> box,centroids;
+                for(uint32_t i=first;i<first+count;++i) {
+                    box.grow(boxes[order[i]]);
+                    centroids.grow(centers[order[i]]);
+                }
+                Node &n=nodes[node];
+                n.box=box;
+                n.offset=first;
+                n.count=count;
+                if(count==1) return;
+
+                // best split among the bin boundaries of the 3 axes, with fewer bins for small ranges
+                int bins=(count<(uint32_t)BINS)?count:BINS;
+                int axis=-1,split=0;
+                T best=std::numeric_limits<T>::infinity();
+                for(int a=0;a<3;++a) {
+                    T low=centroids.get_low()[a],extent=centroids.get_high()[a]-low;
+                    if(extent<=0) continue;
+                    AABB<T> bin_boxes[BINS];
+                    uint32_t bin_counts[BINS]={0};
+                    for(uint32_t i=first;i<first+count;++i) {
+                        int b=bin(centers[order[i]][a],low,extent,bins);
+                        bin_boxes[b].grow(boxes[order[i]]);
+                        ++bin_counts[b];
+                    }
+                    // areas of the boxes on the right of each boundary, then sweep from the left
+                    T right_cost[BINS];
+                    AABB<T> acc;
+                    uint32_t acc_count=0;
+                    for(int b=bins-1;b>0;--b) {
+                        acc.grow(bin_boxes[b]);
+                        acc_count+=bin_counts[b];
+                        right_cost[b]=acc.surface_area()*acc_count;
+                    }
+                    acc=AABB<T>();
+                    acc_count=0;
+                    for(int b=1;b<bins;++b) {
+                        acc.grow(bin_boxes[b-1]);
+                        acc_count+=bin_counts[b-1];
+                        T cost=acc.surface_area()*acc_count+right_cost[b];
+                        if(cost<best) {
+                            best=cost;
+                            axis=a;
+                            split=b;
+                        }
+                    }
+                }
+                if(axis<0) { // all the centroids are at the same place
+                    if(count<=MAX_LEAF_SIZE) return;
+                    axis=0;
+                }
+                // a leaf costs one test per primitive, a split one for the node and one per primitive of the
+                // children, weighted by the probability of hitting them (relative to the area of the box)
+                else if(count<=MAX_LEAF_SIZE&&best>=(count-1)*box.surface_area()) return;
+
+                uint32_t mid=first;
+                if(!centroids.is_empty()&&centroids.get_high()[axis]>centroids.get_low()[axis]) {
+                    T low=centroids.get_low()[axis],extent=centroids.get_high()[axis]-low;
+                    mid=std::partition(order.begin()+first,order.begin()+first+count,[&](uint32_t p) {
+                        return bin(centers[p][axis],low,extent,bins)<split;
+                    })-order.begin();
+                }
+                if(mid==first||mid==first+count) { // no useful split: halve the range
+                    mid=first+count/2;
+                    std::nth_element(order.begin()+first,order.begin()+mid,order.begin()+first+count,
+                                     [&](uint32_t p1, uint32_t p2) { return centers[p1][axis]<centers[p2][axis]; });
+                }
+
+                uint32_t child=next.fetch_add(2);
+                n.offset=child;
+                n.count=0;
+                if(threads>1&&count>=MIN_PARALLEL_SIZE) {
+                    std::thread t([&]() { build_node(child,first,mid-first,boxes,centers,next,threads/2); });
+                    build_node(child+1,mid,first+count-mid,boxes,centers,next,threads-threads/2);
+                    t.join();
+                } else {
+                    build_node(child,first,mid-first,boxes,centers,next,1);
+                    build_node(child+1,mid,first+count-mid,boxes,centers,next,1);
+                }
+            }
+
+            // Returns the bin among bins of a centroid coordinate c, for centroids between low and low+extent. The
+            // result is clamped on both sides, before the conversion to int (NaN going to the first bin).
+            static int bin(T c, T low, T extent, int bins) {
+                T b=bins*((c-low)/extent);
+                if(!(b>0)) return 0;
+                return (b<bins)?(int)b:bins-1;
+            }
+
+            // Returns true if the center of a box given as argument is finite (not the one of an empty box).
+            static bool binnable(const Vector<T,3> &c) {
+                return std::isfinite(c[0])&&std::isfinite(c[1])&&std::isfinite(c[2]);
+            }
+
+            // Returns the range of the primitive order covered by the subtree of the given node.
+            void range(uint32_t node, uint32_t &first, uint32_t &last) const {
+                uint32_t n=node;
+                while(!nodes[n].is_leaf()) n=nodes[n].offset;
+                first=nodes[n].offset;
+                n=node;
+                while(!nodes[n].is_leaf()) n=nodes[n].offset+1;
+                last=nodes[n].offset+nodes[n].count;
+            }
+
+            template<typename S, typename Test, typename Visit>
+            void traverse_node(uint32_t node, S state, Test &test, Visit &visit) const {
+                const Node &n=nodes[node];
+                Overlap o=test(node,n.box,state);
+                if(o==DISJOINT) return;
+                if(o==CONTAINED||n.is_leaf()) {
+                    uint32_t first,last;
+                    range(node,first,last);
+                    for(uint32_t i=first;i<last;++i)
+                        visit(order[i]);
+                    return;
+                }
+                traverse_node(n.offset,state,test,visit);
+                traverse_node(n.offset+1,state,test,visit);
+            }
+
+        public:
+            BVH() {}
+
+            // Builds the hierarchy over the n primitives whose boxes are given as argument, using at most threads
+            // threads (all the cores by default). The primitives whose boxes are empty or not finite (an object
+            // without vertex) have no place to be binned at: they are put together in a leaf of their own, the
+            // second child of the root.
+            void build(const AABB<T> *boxes, size_t n, unsigned int threads=std::thread::hardware_concurrency()) {
+                nodes.clear();
+                order.resize(n);
+                if(n==0) return;
+                std::vector<Vector<T,3>> centers(n);
+                uint32_t valid=0;
+                for(size_t i=0;i<n;++i) {
+                    centers[i]=boxes[i].center();
+                    if(binnable(centers[i])) order[valid++]=i;
+                }
+                for(size_t i=0,k=valid;i<n;++i)
+                    if(!binnable(centers[i])) order[k++]=i;
+                nodes.resize(2*n+1);
+                if(valid==n||valid==0) {
+                    std::atomic<uint32_t> next(1);
+                    if(valid==n) build_node(0,0,n,boxes,centers.data(),next,(threads>0)?threads:1);
+                    else nodes[0]=Node{AABB<T>(),0,(uint32_t)n};
+                    nodes.resize(next);
+                    return;
+                }
+                std::atomic<uint32_t> next(3);
+                build_node(1,0,valid,boxes,centers.data(),next,(threads>0)?threads:1);
+                AABB<T> invalid;
+                for(size_t i=valid;i<n;++i)
+                    invalid.grow(boxes[order[i]]);
+                nodes[2]=Node{invalid,valid,(uint32_t)(n-valid)};
+                AABB<T> root=nodes[1].box;
+                root.grow(invalid);
+                nodes[0]=Node{root,1,0};
+                nodes.resize(next);
+            }
+
+            // Updates the boxes of the nodes after the primitives moved, from the new boxes given as argument
+            // (in the order of the primitives given to build). The children of a node are always after it.
+            void refit(const AABB<T> *boxes) {
+                for(size_t i=nodes.size();i-->0;) {
+                    Node &n=nodes[i];
+                    AABB<T> box;
+                    if(n.is_leaf()) {
+                        for(uint32_t p=n.offset;p<n.offset+n.count;++p)
+                            box.grow(boxes[order[p]]);
+                    } else {
+                        box=nodes[n.offset].box;
+                        box.grow(nodes[n.offset+1].box);
+                    }
+                    n.box=box;
+                }
+            }
+
+            // Visits the primitives of the nodes accepted by test. test(node,box,state) is called on each node
+            // reached from the root: DISJOINT skips its subtree, CONTAINED visits all its primitives without
+            // testing its descendants, and OVERLAPPING goes on with its children, which get a copy of the state
+            // it left (for instance the planes of a frustum left to test). visit(primitive) is called for each
+            // primitive visited. The primitives of a leaf that is only OVERLAPPING are visited without being
+            // tested one by one.
+            template<typename S, typename Test, typename Visit>
+            void traverse(S state, Test test, Visit visit) const {
+                if(!nodes.empty()) traverse_node(0,state,test,visit);
+            }
+
+            // Returns the number of nodes.
+            inline size_t size() const { return nodes.size(); }
+
+            // Returns the node of the given index (the root is 0).
+            inline const Node &get_node(size_t i) const { return nodes[i]; }
+
+            // Returns the index of the i-th primitive in the order of the leaves.
+            inline uint32_t primitive(size_t i) const { return order[i]; }
+    };
+
+    static_assert(sizeof(BVH<float>::Node)==32,"BVH nodes must take 32 bytes");
+}
+
+#endif
@@ -4,12 +4,12 @@
 #include <math.h>
 #include <iostream>
 #include "transform.hpp"
-#include "sphere.hpp"
-#include "triangle.hpp"
+#include "affine.hpp"
 #include "lineSegment.hpp"
 #include "point.hpp"
 #include "direction.hpp"
 #include "frustum.hpp"
+#include "aabb.hpp"
 #include "matrix.hpp"
 
 using namespace libgeometry;
@@ -30,41 +30,42 @@ class Camera {
         Quaternion<float> orientation;
         Vec3r co_speed;
         Frustum frustum;
+        Frustum world_frustum; // field of vision in world space, for culling the scene
         Mat44r proj_matrix;
+        Mat44r clip_proj_matrix; // same image as proj_matrix, with w positive in front of the camera
+        Affine3<float> view; // world to camera space
         Transform<float> transform_matrix;
         bool zooming;
+        bool clip_space; // clips the segments in homogeneous clip space instead of with the view planes
         
+        // Projection matrix for the default vision angle, computed at compile time.
+        static constexpr Mat44r default_proj_matrix=Mat44r::perspective((VISION_ANGLE*M_PI)/180,NEAR_DISTANCE,FAR_DISTANCE);
+
         // Updates the projection matrix of the camera.
         void update_proj_matrix() {
-            proj_matrix=Mat44r{0};
-
-            //float t,b,l,r,a=((alpha*M_PI)/180);
-            //a=1/tan(a/2);
-            //r=t=NEAR_DISTANCE/a;
-            //l=b=-r;
-            
-            float t,r,a=((alpha*M_PI)/180);
+            float a=((alpha*M_PI)/180);
             frustum.update(a);
-            r=t=NEAR_DISTANCE/a;
-            /*proj_matrix=Mat44r{0};
-            proj_matrix[0][0]=(2*NEAR_DISTANCE)/(r-l);
-            proj_matrix[0][2]=(r+l)/(r-l);
-            proj_matrix[1][1]=(2*NEAR_DISTANCE)/(t-b);
-            proj_matrix[1][2]=(t+b)/(t-b);
-            proj_matrix[2][2]=-((FAR_DISTANCE+NEAR_DISTANCE)/(FAR_DISTANCE-NEAR_DISTANCE));
-            proj_matrix[2][3]=-((2*NEAR_DISTANCE*FAR_DISTANCE)/(FAR_DISTANCE-NEAR_DISTANCE));
-            proj_matrix[3][2]=-1;*/
-            proj_matrix=Mat44r{0};
-            proj_matrix[0][0]=(NEAR_DISTANCE)/(r);
-            proj_matrix[1][1]=(NEAR_DISTANCE)/(t);
-            proj_matrix[2][2]=-((FAR_DISTANCE+NEAR_DISTANCE)/(FAR_DISTANCE-NEAR_DISTANCE));
-            proj_matrix[2][3]=-((2*NEAR_DISTANCE*FAR_DISTANCE)/(FAR_DISTANCE-NEAR_DISTANCE));
-            proj_matrix[3][2]=-1;
+            proj_matrix=(alpha==VISION_ANGLE)?default_proj_matrix:Mat44r::perspective(a,NEAR_DISTANCE,FAR_DISTANCE);
+            clip_proj_matrix=clip_projection(proj_matrix);
+        }
+
+        // Returns the projection giving the same image as the one given as argument for a camera looking towards +z
+        // (the one given as argument expects -z): the depth is mirrored, and x, y and w are negated, so that w is
+        // positive in front of the camera and the clip space is -w<=x,y,z<=w.
+        static Mat44r clip_projection(const Mat44r &proj) {
+            Mat44r res=proj;
+            for(int i=0;i<4;++i)
+                res[i][2]=-res[i][2];
+            for(int j=0;j<4;++j) {
+                res[0][j]=-res[0][j];
+                res[1][j]=-res[1][j];
+            }
+            return res;
         }
 
     public:
         Camera() {}
-        Camera(float h, float w) : zooming(false){
+        Camera(float h, float w) : zooming(false), clip_space(false){
             direction=Direction<float,4>{0.f,0.f,1.f};
             orientation=Quaternion<float>(0,direction);
             height=h;
@@ -179,26 +180,45 @@ class Camera {
             zooming=false;
         }
 
-        // Returns the transform corresponding to the viewpoint of the camera.
+        // Returns the position of the camera in world space.
+        inline const Point<float,4> &get_position() const {
+            return position;
+        }
+
+        // Returns the transform from world to camera space (without the projection).
+        const Affine3<float> &get_view() const {
+            return view;
+        }
+
+        // Returns the transform corresponding to the viewpoint of the camera. In clip space mode, it is the one
+        // of clip_projection, so that the points in front of the camera are inside the clip space.
         Transform<float> get_transform() const {
             return transform_matrix;
         }
 
-        // Returns if the sphere given as argument is outside of the field of view of the camera.
-        bool outside_frustum(const Sphere<float,4> &s) const {
-            return frustum.outside(s);
+        // Sets whether the segments are clipped in homogeneous clip space (only against the near and far
+        // planes, the sides being left to the line drawer) instead of with the six planes of the frustum.
+        void set_clip_space(bool b) {
+            clip_space=b;
         }
-        
-        // Returns if the camera “sees” the triangular face given as argument.
-        bool sees(Triangle<float,4> &t) const {
-            Direction<float,4>test=direction;
-            test[0]+=position.at(0);
-            test[1]+=position.at(1);
-            return test.dot(t.normale())>0;
+
+        // Returns the position of the axis-aligned box (in world space) given as argument relative to the field of view
+        // (see Frustum::classify).
+        Frustum::Visibility classify(const AABB<float> &b, unsigned int &mask, unsigned char &last_plane,
+                                     Frustum::CullStats *stats=nullptr) const {
+            return world_frustum.classify(b,mask,last_plane,stats);
+        }
+
+        // Returns the position of the n points given as argument (transformed by get_transform) relative to the field
+        // of view, as seen by visible_part: the segments between points INSIDE do not need to be clipped.
+        Frustum::Visibility classify(const Point<float,4> *points, size_t n) const {
+            if(clip_space) return Frustum::classify_clip_space(points,n);
+            return frustum.classify(points,n);
         }
 
         // Returns the visible part of the segment given as argument.
         LineSegment<float,4> visible_part(const LineSegment<float,4> &ls) const {
+            if(clip_space) return Frustum::clip_homogeneous(ls);
             return frustum.inter(ls);
         }
 
@@ -213,8 +233,11 @@ class Camera {
              }
             position+=cd_speed;
 
-            transform_matrix=Transform<float>(Vec3r{position.at(0),position.at(1),position.at(2)}).concat(Transform<float>(orientation));
-            transform_matrix=Transform<float>(transform_matrix.getM().inverse()).concat(Transform<float>(proj_matrix));
+            view=Affine3<float>(Vec3r{position.x(),position.y(),position.z()}).concat(Affine3<float>(orientation)).inverse();
+            // Only the projection needs the full 4x4 matrix.
+            Mat44r clip=view.project(clip_proj_matrix);
+            world_frustum.update(clip);
+            transform_matrix=Transform<float>(clip_space?clip:view.project(proj_matrix));
         }
 
         ~Camera() {}
@@ -0,0 +1,52 @@
+#ifndef CONSTMATH_HPP
+#define CONSTMATH_HPP
+
+#include <math.h>
+#include <type_traits>
+
+// Math functions usable in constant expressions (the ones of math.h are not constexpr).
+// At run time they call math.h, so the results do not change; at compile time they use series
+// accurate to the double precision on the ranges used by libgeometry.
+namespace libmatrix {
+    namespace constmath {
+
+        // Returns the absolute value of x.
+        template<typename T>
+        constexpr T abs(T x) {
+            return (x<0)?-x:x;
+        }
+
+        // Returns x brought back to [-pi,pi].
+        constexpr double reduce_angle(double x) {
+            double turns=x/(2*M_PI);
+            long long k=(long long)(turns<0?turns-0.5:turns+0.5);
+            return x-k*(2*M_PI);
+        }
+
+        // Returns the sine of x (in radians), with its Taylor series at compile time.
+        template<typename T>
+        constexpr T sin(T x) {
+            if(!std::is_constant_evaluated()) return ::sin(x);
+            double r=reduce_angle(x),r2=r*r,term=r,res=r;
+            for(int i=1;i<14;++i) {
+                term*=-r2/((2*i)*(2*i+1));
+                res+=term;
+            }
+            return res;
+        }
+
+        // Returns the cosine of x (in radians), with its Taylor series at compile time.
+        template<typename T>
+        constexpr T cos(T x) {
+            if(!std::is_constant_evaluated()) return ::cos(x);
+            double r=reduce_angle(x),r2=r*r,term=1,res=1;
+            for(int i=1;i<14;++i) {
+                term*=-r2/((2*i-1)*(2*i));
+                res+=term;
+            }
+            return res;
+        }
+    }
+}
+
+#endif
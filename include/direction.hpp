@@ -11,28 +11,31 @@ namespace libgeometry {
     template<typename T, int N>
     class Direction : public Vector<T,N> {
         public:
-            Direction() {
+            constexpr Direction() {
                 this->array[N-1]=0;
             }
 
-            Direction(const Vector<T,N> v) {
+            constexpr explicit Direction(uninit_t u) : Vector<T,N>(u) {}
+
+            constexpr Direction(const Vector<T,N> v) : Vector<T,N>(uninit) {
                 for(size_t i=0;i<N;++i)
                     this->array[i]=v.at(i);
             }
 
-            Direction(const Vector<T,N-1> v) {
+            template<typename E>
+            constexpr Direction(const VecExpr<E,T,N> &e) : Vector<T,N>(e) {}
+
+            constexpr Direction(const Vector<T,N-1> v) : Vector<T,N>(uninit) {
                 for(size_t i=0;i<N-1;++i)
                     this->array[i]=v.at(i);
                 this->array[N-1]=0;
             }
 
-            Direction(std::initializer_list<T> l) {
+            constexpr Direction(std::initializer_list<T> l) {
                 for(size_t i=0;i<l.size();++i)
                     this->array[i]=l.begin()[i];
                 this->array[N-1]=0;
             }
-
-            ~Direction(){}
     };
 }
 
@@ -0,0 +1,177 @@
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+// Expression templates for the vector and matrix arithmetic.
+// An arithmetic operator returns a small object describing the operation instead of a new
+// Vector or Matrix. The whole expression is evaluated in a single loop when it is assigned to
+// (or used to build) a Vector or a Matrix, without any temporary in between.
+// Operands are referenced, not copied: an expression must not outlive the statement building it.
+
+namespace libmatrix {
+
+    template<typename T,int N>
+    class Vector;
+
+    template<typename T,int N,int M>
+    class Matrix;
+
+    struct OpAdd {
+        template<typename T>
+        static constexpr T apply(T a, T b) { return a+b; }
+    };
+
+    struct OpSub {
+        template<typename T>
+        static constexpr T apply(T a, T b) { return a-b; }
+    };
+
+    struct OpMul {
+        template<typename T>
+        static constexpr T apply(T a, T b) { return a*b; }
+    };
+
+    // Base of the vector expressions of N elements of type T. E is the expression itself,
+    // which gives its i-th element through operator[].
+    template<typename E,typename T,int N>
+    struct VecExpr {
+        typedef T value_type;
+
+        constexpr const E &self() const { return static_cast<const E &>(*this); }
+    };
+
+    // Elements of an existing vector.
+    template<typename T,int N>
+    struct VecRef : public VecExpr<VecRef<T,N>,T,N> {
+        const T *p;
+
+        explicit constexpr VecRef(const T *_p) : p(_p) {}
+        constexpr T operator[](int i) const { return p[i]; }
+    };
+
+    // Element-wise operation between two expressions.
+    template<typename Op,typename L,typename R,typename T,int N>
+    struct VecBinary : public VecExpr<VecBinary<Op,L,R,T,N>,T,N> {
+        L l;
+        R r;
+
+        constexpr VecBinary(const L &_l, const R &_r) : l(_l), r(_r) {}
+        constexpr T operator[](int i) const { return Op::apply(l[i],r[i]); }
+    };
+
+    // Operation between every element of an expression and a scalar.
+    template<typename Op,typename E,typename T,int N>
+    struct VecScalar : public VecExpr<VecScalar<Op,E,T,N>,T,N> {
+        E e;
+        T s;
+
+        constexpr VecScalar(const E &_e, T _s) : e(_e), s(_s) {}
+        constexpr T operator[](int i) const { return Op::apply(e[i],s); }
+    };
+
+    template<typename E1,typename E2,typename T,int N>
+    constexpr VecBinary<OpAdd,E1,E2,T,N> operator+(const VecExpr<E1,T,N> &a, const VecExpr<E2,T,N> &b) {
+        return VecBinary<OpAdd,E1,E2,T,N>(a.self(),b.self());
+    }
+
+    template<typename E,typename T,int N>
+    constexpr VecBinary<OpAdd,E,VecRef<T,N>,T,N> operator+(const VecExpr<E,T,N> &a, const Vector<T,N> &b) {
+        return VecBinary<OpAdd,E,VecRef<T,N>,T,N>(a.self(),VecRef<T,N>(b.data()));
+    }
+
+    template<typename E,typename T,int N>
+    constexpr VecScalar<OpAdd,E,T,N> operator+(const VecExpr<E,T,N> &a, typename VecExpr<E,T,N>::value_type s) {
+        return VecScalar<OpAdd,E,T,N>(a.self(),s);
+    }
+
+    template<typename E1,typename E2,typename T,int N>
+    constexpr VecBinary<OpSub,E1,E2,T,N> operator-(const VecExpr<E1,T,N> &a, const VecExpr<E2,T,N> &b) {
+        return VecBinary<OpSub,E1,E2,T,N>(a.self(),b.self());
+    }
+
+    template<typename E,typename T,int N>
+    constexpr VecBinary<OpSub,E,VecRef<T,N>,T,N> operator-(const VecExpr<E,T,N> &a, const Vector<T,N> &b) {
+        return VecBinary<OpSub,E,VecRef<T,N>,T,N>(a.self(),VecRef<T,N>(b.data()));
+    }
+
+    template<typename E,typename T,int N>
+    constexpr VecScalar<OpMul,E,T,N> operator-(const VecExpr<E,T,N> &a) {
+        return VecScalar<OpMul,E,T,N>(a.self(),-1);
+    }
+
+    template<typename E,typename T,int N>
+    constexpr VecScalar<OpMul,E,T,N> operator*(const VecExpr<E,T,N> &a, typename VecExpr<E,T,N>::value_type s) {
+        return VecScalar<OpMul,E,T,N>(a.self(),s);
+    }
+
+    template<typename E,typename T,int N>
+    constexpr VecScalar<OpMul,E,T,N> operator*(typename VecExpr<E,T,N>::value_type s, const VecExpr<E,T,N> &a) {
+        return VecScalar<OpMul,E,T,N>(a.self(),s);
+    }
+
+    // Base of the matrix expressions of NxM elements of type T. E gives its element (i,j) through operator().
+    template<typename E,typename T,int N,int M>
+    struct MatExpr {
+        typedef T value_type;
+
+        constexpr const E &self() const { return static_cast<const E &>(*this); }
+    };
+
+    // Elements of an existing matrix.
+    template<typename T,int N,int M>
+    struct MatRef : public MatExpr<MatRef<T,N,M>,T,N,M> {
+        const Matrix<T,N,M> *m;
+
+        explicit constexpr MatRef(const Matrix<T,N,M> *_m) : m(_m) {}
+        constexpr T operator()(int i, int j) const { return (*m)[i][j]; }
+    };
+
+    template<typename Op,typename L,typename R,typename T,int N,int M>
+    struct MatBinary : public MatExpr<MatBinary<Op,L,R,T,N,M>,T,N,M> {
+        L l;
+        R r;
+
+        constexpr MatBinary(const L &_l, const R &_r) : l(_l), r(_r) {}
+        constexpr T operator()(int i, int j) const { return Op::apply(l(i,j),r(i,j)); }
+    };
+
+    template<typename Op,typename E,typename T,int N,int M>
+    struct MatScalar : public MatExpr<MatScalar<Op,E,T,N,M>,T,N,M> {
+        E e;
+        T s;
+
+        constexpr MatScalar(const E &_e, T _s) : e(_e), s(_s) {}
+        constexpr T operator()(int i, int j) const { return Op::apply(e(i,j),s); }
+    };
+
+    template<typename E1,typename E2,typename T,int N,int M>
+    constexpr MatBinary<OpAdd,E1,E2,T,N,M> operator+(const MatExpr<E1,T,N,M> &a, const MatExpr<E2,T,N,M> &b) {
+        return MatBinary<OpAdd,E1,E2,T,N,M>(a.self(),b.self());
+    }
+
+    template<typename E,typename T,int N,int M>
+    constexpr MatBinary<OpAdd,E,MatRef<T,N,M>,T,N,M> operator+(const MatExpr<E,T,N,M> &a, const Matrix<T,N,M> &b) {
+        return MatBinary<OpAdd,E,MatRef<T,N,M>,T,N,M>(a.self(),MatRef<T,N,M>(&b));
+    }
+
+    template<typename E1,typename E2,typename T,int N,int M>
+    constexpr MatBinary<OpSub,E1,E2,T,N,M> operator-(const MatExpr<E1,T,N,M> &a, const MatExpr<E2,T,N,M> &b) {
+        return MatBinary<OpSub,E1,E2,T,N,M>(a.self(),b.self());
+    }
+
+    template<typename E,typename T,int N,int M>
+    constexpr MatBinary<OpSub,E,MatRef<T,N,M>,T,N,M> operator-(const MatExpr<E,T,N,M> &a, const Matrix<T,N,M> &b) {
+        return MatBinary<OpSub,E,MatRef<T,N,M>,T,N,M>(a.self(),MatRef<T,N,M>(&b));
+    }
+
+    template<typename E,typename T,int N,int M>
+    constexpr MatScalar<OpMul,E,T,N,M> operator*(const MatExpr<E,T,N,M> &a, typename MatExpr<E,T,N,M>::value_type s) {
+        return MatScalar<OpMul,E,T,N,M>(a.self(),s);
+    }
+
+    template<typename E,typename T,int N,int M>
+    constexpr MatScalar<OpMul,E,T,N,M> operator*(typename MatExpr<E,T,N,M>::value_type s, const MatExpr<E,T,N,M> &a) {
+        return MatScalar<OpMul,E,T,N,M>(a.self(),s);
+    }
+}
+
+#endif
@@ -1,103 +1,319 @@
 #ifndef FRUSTRUM_HPP
 #define FRUSTRUM_HPP
 
-#include <vector>
+#include <stdint.h>
 #include "plane.hpp"
 #include "point.hpp"
 #include "lineSegment.hpp"
+#include "valid.hpp"
+#include "aabb.hpp"
+#include "matrix.hpp"
 
 using namespace libgeometry;
 
 class Frustum {
+    public:
+        // Indices of the planes, whose bits make up the outcodes.
+        enum PlaneIndex { NEAR_PLANE, FAR_PLANE, LEFT_PLANE, RIGHT_PLANE, BOTTOM_PLANE, TOP_PLANE, PLANE_COUNT };
+
+        // Position of a volume relative to the field of vision.
+        enum Visibility { OUTSIDE, INTERSECTING, INSIDE };
+
+        // Mask of the planes a volume has to be tested against, when nothing is known about it.
+        static constexpr unsigned int ALL_PLANES=(1u<<PLANE_COUNT)-1;
+
+        // Number of plane tests made by the classify taking a plane mask, to measure what the caches save.
+        struct CullStats {
+            unsigned long volumes=0,plane_tests=0;
+
+            // Returns the average number of plane tests per volume.
+            float average() const { return volumes?(float)plane_tests/volumes:0; }
+
+            void reset() { volumes=plane_tests=0; }
+        };
+
     private:
-        Plane<float,4> near,far,right,left,bottom,top;
+        Plane<float,4> planes[PLANE_COUNT];
         float f_dist,n_dist,ratio;
 
-        //Returns the list of planes for which the point given as argument is behind.
-        vector<Plane<float,4>> get_planes_behind(Point<float,4> &p) const {
-            vector<Plane<float,4>> v;
-            if(p.behind(near)) {
-                v.push_back(near);}
-            if(p.behind(far)) {
-                v.push_back(far);}
-            if(p.behind(right)) {
-                v.push_back(right);}
-            if(p.behind(left)) {
-                v.push_back(left);}
-            if(p.behind(bottom)) {
-                v.push_back(bottom);}
-            if(p.behind(top)) {
-                v.push_back(top);}
-            return v;
-        }
-        
+        // Returns true if the sphere of the given center and radius is behind the plane given as argument.
+        static bool behind(const Valid<Point<float,4>> &center, float radius, const Plane<float,4> &p) {
+            float dist_center=center.distance(p);
+            return dist_center<0&&dist_center+radius<0;
+        }
+
+        // Returns the point at the parameter t of the segment going from b to e (w included).
+        static Point<float,4> lerp(const Point<float,4> &b, const Point<float,4> &e, float t) {
+            Point<float,4> res(uninit);
+            for(int i=0;i<4;++i)
+                res[i]=b[i]+(e[i]-b[i])*t;
+            return res;
+        }
+
+        // Returns the signed distance (up to a factor) between the point given as argument and the plane i
+        // of homogeneous clip space, the side planes being pushed out by the factor band. It is positive inside.
+        static float clip_distance(const Point<float,4> &p, int i, float band) {
+            switch(i) {
+                case NEAR_PLANE: return p.w()+p.z();
+                case FAR_PLANE: return p.w()-p.z();
+                case LEFT_PLANE: return band*p.w()+p.x();
+                case RIGHT_PLANE: return band*p.w()-p.x();
+                case BOTTOM_PLANE: return band*p.w()+p.y();
+                default: return band*p.w()-p.y();
+            }
+        }
+
+        // Classifies a volume whose signed distance to the center of the plane i is dist(i), and whose extent
+        // towards the normal of the plane i is radius(i). See the classify taking a mask.
+        template<typename D, typename R>
+        Visibility classify_planes(D dist, R radius, unsigned int &mask, unsigned char &last_plane, CullStats *stats) const {
+            if(stats) ++stats->volumes;
+            for(int k=0;k<PLANE_COUNT;++k) {
+                // the last rejecting plane first, then the others in order
+                int i=(k==0)?last_plane:(k<=last_plane)?k-1:k;
+                if(!(mask&(1u<<i))) continue;
+                if(stats) ++stats->plane_tests;
+                float d=dist(i),r=radius(i);
+                if(d<0&&d+r<0) {
+                    last_plane=i;
+                    return OUTSIDE;
+                }
+                if(d-r>=0) mask&=~(1u<<i);
+            }
+            return mask?INTERSECTING:INSIDE;
+        }
+
     public:
+        // Factor by which the side planes are pushed out in homogeneous clip space: the parts of the segments
+        // between the field of vision and the guard band are left to the line drawer, which clips in 2D.
+        static constexpr float guard_band=16;
+
         Frustum() {}
         Frustum(float f,float n, float r) : f_dist(f), n_dist(n), ratio(r){}
 
         // Updates the position of the field of vision, where h is the horizontal resolution, v is the vertical resolution
         // and e is the distance between the projection plane and the camera.
         void update(float e) {
-            near=Plane<float,4>(Vector<float,4>{0,0,-1,-n_dist});
-            far=Plane<float,4>(Vector<float,4>{0,0,1,f_dist});
-            left=Plane<float,4>(Vector<float,4>{e,0,-1,0});
-            right=Plane<float,4>(Vector<float,4>{-e,0,-1,0});
-            bottom=Plane<float,4>(Vector<float,4>{0,e,-ratio,0});
-            top=Plane<float,4>(Vector<float,4>{0,-e,-ratio,0});
+            planes[NEAR_PLANE]=Plane<float,4>(Vector<float,4>{0,0,-1,-n_dist});
+            planes[FAR_PLANE]=Plane<float,4>(Vector<float,4>{0,0,1,f_dist});
+            planes[LEFT_PLANE]=Plane<float,4>(Vector<float,4>{e,0,-1,0});
+            planes[RIGHT_PLANE]=Plane<float,4>(Vector<float,4>{-e,0,-1,0});
+            planes[BOTTOM_PLANE]=Plane<float,4>(Vector<float,4>{0,e,-ratio,0});
+            planes[TOP_PLANE]=Plane<float,4>(Vector<float,4>{0,-e,-ratio,0});
+        }
+
+        // Sets the planes to the ones bounding the clip space of the matrix given as argument (-w<=x,y,z<=w after
+        // the transform). For a view-projection matrix, they bound the field of vision in world space.
+        void update(const Matrix<float,4,4> &m) {
+            planes[NEAR_PLANE]=Plane<float,4>(Vector<float,4>(m[3]+m[2]));
+            planes[FAR_PLANE]=Plane<float,4>(Vector<float,4>(m[3]-m[2]));
+            planes[LEFT_PLANE]=Plane<float,4>(Vector<float,4>(m[3]+m[0]));
+            planes[RIGHT_PLANE]=Plane<float,4>(Vector<float,4>(m[3]-m[0]));
+            planes[BOTTOM_PLANE]=Plane<float,4>(Vector<float,4>(m[3]+m[1]));
+            planes[TOP_PLANE]=Plane<float,4>(Vector<float,4>(m[3]-m[1]));
+        }
+
+        // Returns the plane of the given index.
+        inline const Plane<float,4> &get_plane(int i) const { return planes[i]; }
+
+        // Returns the outcode of the point given as argument: the bit i is set if the point is behind the plane i.
+        unsigned int outcode(const Valid<Point<float,4>> &p) const {
+            unsigned int code=0;
+            for(int i=0;i<PLANE_COUNT;++i)
+                code|=(unsigned int)p.behind(planes[i])<<i;
+            return code;
         }
 
         // Returns if the point given as argument is outside the field of vision.
-        bool outside(const Point<float,4> &p) const {
-            return p.behind(near)||p.behind(far)||p.behind(left)||p.behind(right)||p.behind(bottom)||p.behind(top);
+        bool outside(const Point<float,4> &_p) const {
+            if(_p.is_null()) return true;
+            return outcode(Valid<Point<float,4>>(_p))!=0;
         }
 
         // Returns if the sphere given as argument is completely outside the field of vision.
         bool outside(const Sphere<float,4> &s) const {
-            return s.behind(near)||s.behind(far)||s.behind(left)||s.behind(right)||s.behind(bottom)||s.behind(top);
+            if(s.is_null()) return true;
+            Valid<Point<float,4>> c(s.getCenter());
+            float r=s.getRadius();
+            for(int i=0;i<PLANE_COUNT;++i)
+                if(behind(c,r,planes[i])) return true;
+            return false;
          }
 
-        // Returns the intersection between the segment and the field of vision (visible part).
-        LineSegment<float,4> inter(const LineSegment<float,4> &ls) const {
-            Point<float,4> b=ls.get_begin(), e=ls.get_end(),p;
-            vector<Plane<float,4>> planes_b=get_planes_behind(b),planes_e=get_planes_behind(e);
-            
-            if(planes_b.size()==0&&planes_e.size()==0) return ls; //both inside
-            if(planes_b.size()==0) { //only b inside frustum
-                for(size_t i=0;i<planes_e.size();++i) {
-                    p=ls.inter(planes_e[i]);
-                    if(!p.is_null())
-                        return LineSegment<float,4>(b,p);
-                }
+        // Returns if the sphere given as argument is completely outside the field of vision, completely inside it,
+        // or crosses some of its planes.
+        Visibility classify(const Sphere<float,4> &s) const {
+            if(s.is_null()) return OUTSIDE;
+            Valid<Point<float,4>> c(s.getCenter());
+            float r=s.getRadius();
+            Visibility res=INSIDE;
+            for(int i=0;i<PLANE_COUNT;++i) {
+                float dist=c.distance(planes[i]);
+                if(dist<0&&dist+r<0) return OUTSIDE;
+                if(!(dist-r>=0)) res=INTERSECTING;
             }
-            if(planes_e.size()==0) { //only e inside frustum
-                for(size_t i=0;i<planes_b.size();++i) {
-                    p=ls.inter(planes_b[i]);
-                    if(!p.is_null())
-                        return LineSegment<float,4>(e,p);
-                }
+            return res;
+        }
+
+        // Same as classify, using what is known about the sphere from the previous frame and from its parents.
+        // mask holds the planes to test (ALL_PLANES for a root volume); the planes the sphere is completely in
+        // front of are removed from it, so that it can be given to the volumes the sphere contains. last_plane is
+        // tested first: it holds the plane that rejected the sphere the last time, and is updated on rejection.
+        Visibility classify(const Sphere<float,4> &s, unsigned int &mask, unsigned char &last_plane, CullStats *stats=nullptr) const {
+            if(s.is_null()) {
+                if(stats) ++stats->volumes;
+                return OUTSIDE;
             }
+            Valid<Point<float,4>> c(s.getCenter());
+            float r=s.getRadius();
+            return classify_planes([&](int i) { return c.distance(planes[i]); },[&](int) { return r; },mask,last_plane,stats);
+        }
 
-            //both points are outside : search two intersection points (0 if no intersection)
-            Point<float,4> ls2[2];
-            int cpt=0;
-            bool present;
-            vector<Plane<float,4>> unique_plans=planes_b; //planes for which at least one point is behind
-            for(size_t i=0;i<planes_e.size();++i) {
-                present=false;
-                for(size_t j=0;j<planes_b.size();++j) {
-                    if(planes_e[i]==planes_b[j])
-                        present=true;
-                }
-                if(!present)
-                    unique_plans.push_back(planes_e[i]);
+        // Same as classify for an axis-aligned box.
+        Visibility classify(const AABB<float> &b, unsigned int &mask, unsigned char &last_plane, CullStats *stats=nullptr) const {
+            if(b.is_empty()) {
+                if(stats) ++stats->volumes;
+                return OUTSIDE;
+            }
+            Vector<float,3> c=b.center(),e=b.extents();
+            return classify_planes([&](int i) {
+                const Plane<float,4> &p=planes[i];
+                return ((p[0]*c[0]+p[1]*c[1])+p[2]*c[2])+p[3];
+            },[&](int i) {
+                const Plane<float,4> &p=planes[i];
+                return (fabsf(p[0])*e[0]+fabsf(p[1])*e[1])+fabsf(p[2])*e[2];
+            },mask,last_plane,stats);
+        }
+
+        // Returns the position of the n points given as argument (all valid) relative to the field of vision,
+        // from their outcodes: INSIDE if they are all in it, OUTSIDE if they are all behind the same plane.
+        // The segments between points INSIDE are left unchanged by inter, and the ones between points OUTSIDE
+        // are removed.
+        Visibility classify(const Point<float,4> *points, size_t n) const {
+            unsigned int all=(1u<<PLANE_COUNT)-1,any=0;
+            for(size_t i=0;i<n;++i) {
+                unsigned int code=outcode(Valid<Point<float,4>>(points[i]));
+                all&=code;
+                any|=code;
+            }
+            if(all) return OUTSIDE;
+            return any?INTERSECTING:INSIDE;
+        }
+
+        // Returns if the axis-aligned box of the given center and half extents is completely outside the field of vision.
+        bool outside(const Point<float,4> &center, const Vector<float,3> &extents) const {
+            if(center.is_null()) return true;
+            Valid<Point<float,4>> c(center);
+            for(int i=0;i<PLANE_COUNT;++i) {
+                const Plane<float,4> &p=planes[i];
+                float radius=(fabsf(p[0])*extents[0]+fabsf(p[1])*extents[1])+fabsf(p[2])*extents[2];
+                if(!(c.distance(p)+radius>=0)) return true;
+            }
+            return false;
+        }
+
+        // Tests n spheres given as one array per coordinate of their centers and one for their radii. Sets the bit
+        // i%32 of visible[i/32] if the sphere i is not completely outside the field of vision (the same answer as
+        // outside), and clears it otherwise. visible must hold (n+31)/32 words. If inside is not null, its bits are
+        // set the same way for the spheres classified INSIDE. The planes are tested on several spheres at once with SIMD.
+        void visible_spheres(const float *x, const float *y, const float *z, const float *r, size_t n, uint32_t *visible,
+                             uint32_t *inside=nullptr) const {
+            const float *p[PLANE_COUNT];
+            for(int i=0;i<PLANE_COUNT;++i)
+                p[i]=planes[i].data();
+            const float *in[4]={x,y,z,r};
+            libmatrix::simd::Kernels<float,4>::cull_spheres(p,PLANE_COUNT,in,n,visible,inside);
+        }
+
+        // Same as visible_spheres, for axis-aligned boxes given by their centers and half extents.
+        void visible_boxes(const float *x, const float *y, const float *z, const float *ex, const float *ey, const float *ez,
+                           size_t n, uint32_t *visible) const {
+            const float *p[PLANE_COUNT];
+            for(int i=0;i<PLANE_COUNT;++i)
+                p[i]=planes[i].data();
+            const float *in[6]={x,y,z,ex,ey,ez};
+            libmatrix::simd::Kernels<float,4>::cull_boxes(p,PLANE_COUNT,in,n,visible);
+        }
+
+        // Returns the intersection between the segment and the field of vision (visible part), or a null segment
+        // if it is completely outside. The segment is clipped parametrically (Liang-Barsky) against the planes
+        // set in the outcodes of its ends only.
+        LineSegment<float,4> inter(const LineSegment<float,4> &ls) const {
+            if(ls.is_null()) return LineSegment<float,4>();
+            Valid<Point<float,4>> b(ls.get_begin()), e(ls.get_end());
+            unsigned int code_b=outcode(b),code_e=outcode(e);
+
+            if((code_b|code_e)==0) return ls; //both inside
+            if(code_b&code_e) return LineSegment<float,4>(); //both behind the same plane
+
+            // the visible part is [t_b,t_e] on the segment, where the signed distance to each plane
+            // goes linearly from dist_b to dist_e
+            float t_b=0,t_e=1;
+            unsigned int code=code_b|code_e;
+            for(int i=0;i<PLANE_COUNT;++i) {
+                if(!(code&(1u<<i))) continue;
+                float dist_b=b.distance(planes[i]),dist_e=e.distance(planes[i]);
+                float t=dist_b/(dist_b-dist_e);
+                if(dist_b<0) { //entering the half-space
+                    if(t>t_b) t_b=t;
+                } else if(t<t_e) t_e=t; //leaving it
+                if(t_b>t_e) return LineSegment<float,4>();
+            }
+            return LineSegment<float,4>(code_b?lerp(b,e,t_b):b,code_e?lerp(b,e,t_e):e);
+        }
+
+        // Returns the outcode of the point given as argument in homogeneous clip space (-w<=x,y,z<=w), the side
+        // planes being pushed out by the factor band: the bit i is set if the point is outside the plane i.
+        static unsigned int clip_outcode(const Point<float,4> &p, float band=1) {
+            unsigned int code=0;
+            for(int i=0;i<PLANE_COUNT;++i)
+                code|=(unsigned int)(clip_distance(p,i,band)<0)<<i;
+            return code;
+        }
+
+        // Same as classify for n points in homogeneous clip space, relative to the planes -w<=x,y,z<=w: the segments
+        // between points INSIDE are left unchanged by clip_homogeneous.
+        static Visibility classify_clip_space(const Point<float,4> *points, size_t n) {
+            unsigned int all=(1u<<PLANE_COUNT)-1,any=0;
+            for(size_t i=0;i<n;++i) {
+                unsigned int code=clip_outcode(points[i]);
+                all&=code;
+                any|=code;
             }
-            for(size_t i=0;i<unique_plans.size();++i) {
-                ls2[cpt]=ls.inter(unique_plans[i]);
-                if(!ls2[cpt].is_null())
-                    if(++cpt==2)
-                        return LineSegment<float,4>(ls2[0],ls2[1]);
+            if(all) return OUTSIDE;
+            return any?INTERSECTING:INSIDE;
+        }
+
+        // Returns the part of the segment given as argument (in homogeneous clip space, before the division by w)
+        // to draw, or a null segment if it is completely outside. The segment is only clipped against the near
+        // and far planes and the guard band: the ones that only cross the sides of the field of vision are
+        // returned unchanged, and the line drawer clips them.
+        static LineSegment<float,4> clip_homogeneous(const LineSegment<float,4> &ls) {
+            if(ls.is_null()) return LineSegment<float,4>();
+            Point<float,4> b=ls.get_begin(), e=ls.get_end();
+            unsigned int code_b=clip_outcode(b),code_e=clip_outcode(e);
+
+            if((code_b|code_e)==0) return ls; //both inside
+            if(code_b&code_e) return LineSegment<float,4>(); //both outside the same plane
+
+            // the sides are only clipped beyond the guard band
+            const unsigned int depth=(1u<<NEAR_PLANE)|(1u<<FAR_PLANE);
+            code_b=(code_b&depth)|(clip_outcode(b,guard_band)&~depth);
+            code_e=(code_e&depth)|(clip_outcode(e,guard_band)&~depth);
+            if((code_b|code_e)==0) return ls;
+
+            float t_b=0,t_e=1;
+            unsigned int code=code_b|code_e;
+            for(int i=0;i<PLANE_COUNT;++i) {
+                if(!(code&(1u<<i))) continue;
+                float dist_b=clip_distance(b,i,guard_band),dist_e=clip_distance(e,i,guard_band);
+                float t=dist_b/(dist_b-dist_e);
+                if(dist_b<0) {
+                    if(t>t_b) t_b=t;
+                } else if(t<t_e) t_e=t;
+                if(t_b>t_e) return LineSegment<float,4>();
             }
-            return LineSegment<float,4>();
+            return LineSegment<float,4>(code_b?lerp(b,e,t_b):b,code_e?lerp(b,e,t_e):e);
         }
 
         ~Frustum() {}
@@ -313,8 +313,8 @@ Vec2i Gui::screen_coords( Vec2r cc ) const
 {
     // On the screen, y coordinates are inverted !
     // Thus, you have to turn 180 degrees on the x axis.
-    return (Vec2i) { (int) ( cc[0] * this->window_center.at(0) + this->window_center.at(0)),
-                     (int) (-cc[1] * this->window_center.at(0) + this->window_center.at(1))};
+    return Vec2i { (int) ( cc.x() * this->window_center.x() + this->window_center.x()),
+                   (int) (-cc.y() * this->window_center.x() + this->window_center.y())};
 }
 
 //! Renders a point to the screen.
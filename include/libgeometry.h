@@ -10,5 +10,44 @@
 #include "sphere.hpp"
 #include "rectangle.hpp"
 #include "triangle.hpp"
+#include "aabb.hpp"
+#include "ray.hpp"
+#include <type_traits>
+
+namespace libgeometry {
+    // Geometric types are plain values, so that they can be stored densely and copied with memcpy.
+    template<typename T>
+    struct is_plain_value {
+        static const bool value=std::is_trivially_copyable<T>::value&&std::is_standard_layout<T>::value;
+    };
+
+    // Size of members of the given total size, padded to the given alignment.
+    constexpr size_t padded_size(size_t size, size_t alignment) {
+        return (size+alignment-1)/alignment*alignment;
+    }
+
+    static_assert(is_plain_value<Point<float,4>>::value&&sizeof(Point<float,4>)==4*sizeof(float),
+                  "Point must be a plain 4-float value");
+    static_assert(is_plain_value<Direction<float,4>>::value&&sizeof(Direction<float,4>)==4*sizeof(float),
+                  "Direction must be a plain 4-float value");
+    static_assert(is_plain_value<Plane<float,4>>::value&&sizeof(Plane<float,4>)==4*sizeof(float),
+                  "Plane must be a plain 4-float value");
+    static_assert(is_plain_value<Quaternion<float>>::value&&sizeof(Quaternion<float>)==4*sizeof(float),
+                  "Quaternion must be a plain 4-float value");
+    static_assert(is_plain_value<Sphere<float,4>>::value&&
+                  sizeof(Sphere<float,4>)==padded_size(5*sizeof(float),alignof(Point<float,4>)),
+                  "Sphere must be a plain value");
+    static_assert(is_plain_value<Triangle<float,4>>::value&&
+                  sizeof(Triangle<float,4>)==padded_size(13*sizeof(float),alignof(Point<float,4>)),
+                  "Triangle must be a plain value");
+    static_assert(is_plain_value<LineSegment<float,4>>::value&&
+                  sizeof(LineSegment<float,4>)==padded_size(12*sizeof(float),alignof(Point<float,4>)),
+                  "LineSegment must be a plain value");
+    static_assert(is_plain_value<AABB<float>>::value&&sizeof(AABB<float>)==6*sizeof(float),
+                  "AABB must be a plain 6-float value");
+    static_assert(is_plain_value<Transform<float>>::value&&
+                  sizeof(Transform<float>)==padded_size(sizeof(Mat44r)+sizeof(Quaternion<float>)+sizeof(TransformKind),alignof(Mat44r)),
+                  "Transform must be a plain value");
+}
 
 #endif
\ No newline at end of file
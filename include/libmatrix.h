@@ -3,5 +3,20 @@
 
 #include "vector.hpp"
 #include "matrix.hpp"
+#include <type_traits>
+
+namespace libmatrix {
+    // Vectors and matrices are plain values: no vtable, no padding, copyable with memcpy.
+    static_assert(std::is_trivially_copyable<Vec4r>::value&&std::is_standard_layout<Vec4r>::value,
+                  "Vector must be trivially copyable and standard-layout");
+    static_assert(std::is_trivially_copyable<Mat44r>::value&&std::is_standard_layout<Mat44r>::value,
+                  "Matrix must be trivially copyable and standard-layout");
+    static_assert(sizeof(Vec2i)==2*sizeof(int)&&sizeof(Vec4i)==4*sizeof(int),"Vector must only store its elements");
+    static_assert(sizeof(Vec2r)==2*sizeof(float)&&sizeof(Vec3r)==3*sizeof(float)&&sizeof(Vec4r)==4*sizeof(float),
+                  "Vector must only store its elements");
+    static_assert(sizeof(Mat44r)==16*sizeof(float),"Matrix must only store its elements");
+    static_assert(alignof(Vec4r)==4*sizeof(float)&&alignof(Vec2r)==2*sizeof(float)&&alignof(Mat44r)==alignof(Vec4r),
+                  "2 and 4-element vectors must be aligned for SIMD loads");
+}
 
 #endif
\ No newline at end of file
@@ -14,12 +14,10 @@ namespace libgeometry {
         private:
             Point<T,N> p1,p2;
             Direction<T,N> d;
-            T length;
         public:
             LineSegment(){}
             LineSegment(const Point<T,N> &_p1, const Point<T,N> &_p2) : p1(_p1),p2(_p2){
                 d=p1.length_to(p2);
-                length=d.norm();
             }
 
             // Returns the starting point of the segment.
@@ -45,12 +43,10 @@ namespace libgeometry {
                     return p1;
                 }
                 coef = -(p.dot(p1)/p.dot(d));
-                Vector<T,N> resv = coef*d;
-                Point<T,N> res(resv);
-                res+=p1;
+                Point<T,N> res(coef*d+p1);
 
                 // only return point if it is part of the segment
-                if(p1.length_to(res).norm()<=length&&p2.length_to(res).norm()<=length)
+                if(coef>=0&&coef<=1)
                     return res;
                 return Point<T,N>();
             }
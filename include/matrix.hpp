@@ -2,8 +2,13 @@
 #define MATRIX_HPP
 
 #include "vector.hpp"
+#include "simd.hpp"
+#include "expression.hpp"
+#include "tags.hpp"
+#include "unroll.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <utility>
 
 namespace libmatrix {
     template<typename T,int N>
@@ -13,15 +18,37 @@ namespace libmatrix {
     class Matrix {
         private:
             Vector<T,M> array[N];
+
+            typedef MatRef<T,N,M> Ref;
+
+            // Builds every row with the tag given as argument.
+            template<typename Tag,int... I>
+            constexpr Matrix(Tag tag, std::integer_sequence<int,I...>) : array{((void)I,Vector<T,M>(tag))...} {}
         
         public:
-            Matrix() {}
+            constexpr Matrix() {}
+
+            constexpr explicit Matrix(uninit_t u) : Matrix(u,std::make_integer_sequence<int,N>()) {}
+
+            constexpr explicit Matrix(zero_t z) : Matrix(z,std::make_integer_sequence<int,N>()) {}
 
-            Matrix(std::initializer_list<T> l) {
+            // Evaluates an arithmetic expression into the new matrix, in a single loop.
+            template<typename E>
+            constexpr Matrix(const MatExpr<E,T,N,M> &e) : Matrix(uninit) {
+                unroll<N*M>([&](int k) { array[k/M][k%M]=e.self()(k/M,k%M); });
+            }
+
+            template<typename E>
+            constexpr Matrix<T,N,M> &operator=(const MatExpr<E,T,N,M> &e) {
+                unroll<N*M>([&](int k) { array[k/M][k%M]=e.self()(k/M,k%M); });
+                return *this;
+            }
+
+            constexpr Matrix(std::initializer_list<T> l) {
                 if(l.size()==1) {
                     for(int i=0;i<N;++i)
                         for(int j=0;j<M;++j)
-                            array[j][i]=l.begin()[0];
+                            array[i][j]=l.begin()[0];
                 } else {
                     int j=0,k=0;
                     for(size_t i=0;i<l.size();++i,++k) {
@@ -36,8 +63,8 @@ namespace libmatrix {
 
             // Addresses element (i, j) of the matrix.
             // Raises an exception if i or j is out of range.
-            T at(int i, int j) const {
-                T t;
+            constexpr T at(int i, int j) const {
+                T t=0;
                 try {
                     if(i<N) t = array[i].at(j);
                     else throw std::out_of_range("Vector::at : i out of range");
@@ -48,16 +75,29 @@ namespace libmatrix {
             }
             
             // Returns the identity matrix.
-            Matrix<T,N,M> identity() const {
-                Matrix<T,N,M> id;
+            static constexpr Matrix<T,N,M> identity() {
+                Matrix<T,N,M> id(uninit);
                 for(int i=0;i<N;++i)
                     for(int j=0;j<M;++j)
                         id[j][i]=(j==i)?1:0;
                 return id;
             }
 
+            // Returns the 4x4 perspective projection matrix scaling x and y by focal, and mapping depths
+            // between near and far to [-1,1].
+            static constexpr Matrix<T,N,M> perspective(T focal, T near, T far) {
+                static_assert(N==4&&M==4,"Matrix::perspective : 4x4 matrices only");
+                Matrix<T,N,M> proj(zero);
+                proj[0][0]=focal;
+                proj[1][1]=focal;
+                proj[2][2]=-((far+near)/(far-near));
+                proj[2][3]=-((2*near*far)/(far-near));
+                proj[3][2]=-1;
+                return proj;
+            }
+
             // returns the inverse of the matrix. Returns a null matrix if the current matrix is not invertible.
-            Matrix<T,N,M> inverse() const {
+            constexpr Matrix<T,N,M> inverse() const {
                 if(N!=M) return Matrix<T,N,M>();
                 Matrix<T,N,M> inv=*this;
                 Matrix<T,N,M> id=identity();
@@ -100,8 +140,82 @@ namespace libmatrix {
                 return id;
             }
             
+            // Returns the inverse of a 4x4 rigid transform matrix (rotation and translation only):
+            // the transposed rotation and the translation rotated back and negated.
+            constexpr Matrix<T,N,M> inverse_rigid() const {
+                static_assert(N==4&&M==4,"Matrix::inverse_rigid : 4x4 matrices only");
+                Matrix<T,N,M> inv(uninit);
+                for(int i=0;i<3;++i) {
+                    for(int j=0;j<3;++j)
+                        inv[i][j]=array[j][i];
+                    inv[i][3]=-(array[0][i]*array[0][3]+array[1][i]*array[1][3]+array[2][i]*array[2][3]);
+                    inv[3][i]=0;
+                }
+                inv[3][3]=1;
+                return inv;
+            }
+
+            // Returns the inverse of a 4x4 affine matrix (last row 0 0 0 1), by inverting its 3x3 part
+            // with cofactors. Returns a null matrix if the matrix is not invertible.
+            constexpr Matrix<T,N,M> inverse_affine() const {
+                static_assert(N==4&&M==4,"Matrix::inverse_affine : 4x4 matrices only");
+                const Vector<T,M> &r0=array[0],&r1=array[1],&r2=array[2];
+                T c00=r1[1]*r2[2]-r1[2]*r2[1],c01=r1[2]*r2[0]-r1[0]*r2[2],c02=r1[0]*r2[1]-r1[1]*r2[0];
+                T det=r0[0]*c00+r0[1]*c01+r0[2]*c02;
+                if(det==0) return Matrix<T,N,M>();
+                T d=1/det;
+                Matrix<T,N,M> inv(uninit);
+                inv[0][0]=c00*d;
+                inv[0][1]=(r0[2]*r2[1]-r0[1]*r2[2])*d;
+                inv[0][2]=(r0[1]*r1[2]-r0[2]*r1[1])*d;
+                inv[1][0]=c01*d;
+                inv[1][1]=(r0[0]*r2[2]-r0[2]*r2[0])*d;
+                inv[1][2]=(r0[2]*r1[0]-r0[0]*r1[2])*d;
+                inv[2][0]=c02*d;
+                inv[2][1]=(r0[1]*r2[0]-r0[0]*r2[1])*d;
+                inv[2][2]=(r0[0]*r1[1]-r0[1]*r1[0])*d;
+                for(int i=0;i<3;++i) {
+                    inv[i][3]=-(inv[i][0]*r0[3]+inv[i][1]*r1[3]+inv[i][2]*r2[3]);
+                    inv[3][i]=0;
+                }
+                inv[3][3]=1;
+                return inv;
+            }
+
+            // Returns the inverse of a 4x4 matrix computed with cofactors (2x2 sub-determinants).
+            // Returns a null matrix if the matrix is not invertible.
+            constexpr Matrix<T,N,M> inverse_cofactor() const {
+                static_assert(N==4&&M==4,"Matrix::inverse_cofactor : 4x4 matrices only");
+                const Vector<T,M> &a0=array[0],&a1=array[1],&a2=array[2],&a3=array[3];
+                T s0=a0[0]*a1[1]-a1[0]*a0[1],s1=a0[0]*a1[2]-a1[0]*a0[2],s2=a0[0]*a1[3]-a1[0]*a0[3];
+                T s3=a0[1]*a1[2]-a1[1]*a0[2],s4=a0[1]*a1[3]-a1[1]*a0[3],s5=a0[2]*a1[3]-a1[2]*a0[3];
+                T c5=a2[2]*a3[3]-a3[2]*a2[3],c4=a2[1]*a3[3]-a3[1]*a2[3],c3=a2[1]*a3[2]-a3[1]*a2[2];
+                T c2=a2[0]*a3[3]-a3[0]*a2[3],c1=a2[0]*a3[2]-a3[0]*a2[2],c0=a2[0]*a3[1]-a3[0]*a2[1];
+                T det=s0*c5-s1*c4+s2*c3+s3*c2-s4*c1+s5*c0;
+                if(det==0) return Matrix<T,N,M>();
+                T d=1/det;
+                Matrix<T,N,M> inv(uninit);
+                inv[0][0]=( a1[1]*c5-a1[2]*c4+a1[3]*c3)*d;
+                inv[0][1]=(-a0[1]*c5+a0[2]*c4-a0[3]*c3)*d;
+                inv[0][2]=( a3[1]*s5-a3[2]*s4+a3[3]*s3)*d;
+                inv[0][3]=(-a2[1]*s5+a2[2]*s4-a2[3]*s3)*d;
+                inv[1][0]=(-a1[0]*c5+a1[2]*c2-a1[3]*c1)*d;
+                inv[1][1]=( a0[0]*c5-a0[2]*c2+a0[3]*c1)*d;
+                inv[1][2]=(-a3[0]*s5+a3[2]*s2-a3[3]*s1)*d;
+                inv[1][3]=( a2[0]*s5-a2[2]*s2+a2[3]*s1)*d;
+                inv[2][0]=( a1[0]*c4-a1[1]*c2+a1[3]*c0)*d;
+                inv[2][1]=(-a0[0]*c4+a0[1]*c2-a0[3]*c0)*d;
+                inv[2][2]=( a3[0]*s4-a3[1]*s2+a3[3]*s0)*d;
+                inv[2][3]=(-a2[0]*s4+a2[1]*s2-a2[3]*s0)*d;
+                inv[3][0]=(-a1[0]*c3+a1[1]*c1-a1[2]*c0)*d;
+                inv[3][1]=( a0[0]*c3-a0[1]*c1+a0[2]*c0)*d;
+                inv[3][2]=(-a3[0]*s3+a3[1]*s1-a3[2]*s0)*d;
+                inv[3][3]=( a2[0]*s3-a2[1]*s1+a2[2]*s0)*d;
+                return inv;
+            }
+
             // Returns true if the matrix contains invalid values, false otherwise.
-            bool is_null() const {
+            constexpr bool is_null() const {
                 if (std::is_same<T, int>::value) {
                     for(int i=0;i<N;++i)
                         if(array[i].is_null()) return true;
@@ -119,8 +233,8 @@ namespace libmatrix {
             }
             
             // Returns the transpose of the matrix.
-            Matrix<T,M,N> transpose() const {
-                Matrix<T,M,N> res;
+            constexpr Matrix<T,M,N> transpose() const {
+                Matrix<T,M,N> res(uninit);
                 int k=0,l=0;
                 for(int i=0;i<N;++i) {
                     for(int j=0;j<M;++j) {
@@ -135,72 +249,97 @@ namespace libmatrix {
             template<typename U, int O, int P>
             friend std::ostream &operator<<(std::ostream &out, Matrix<U,O,P> m);
             
-            inline Vector<T,M> &operator[](const int i) { return array[i]; }
+            constexpr Vector<T,M> &operator[](const int i) { return array[i]; }
+            constexpr const Vector<T,M> &operator[](const int i) const { return array[i]; }
             
-            Matrix<T,N,M> operator +(const Matrix<T,N,M> m) const {
-                Matrix<T,N,M> res;
-                for(int i=0;i<N;++i)
-                    res[i]=array[i]+m[i];
-                return res;
+            // Arithmetic operators return expressions (see expression.hpp), evaluated when assigned.
+            constexpr MatBinary<OpAdd,Ref,Ref,T,N,M> operator +(const Matrix<T,N,M> &m) const {
+                return MatBinary<OpAdd,Ref,Ref,T,N,M>(Ref(this),Ref(&m));
+            }
+
+            template<typename E>
+            constexpr MatBinary<OpAdd,Ref,E,T,N,M> operator +(const MatExpr<E,T,N,M> &e) const {
+                return MatBinary<OpAdd,Ref,E,T,N,M>(Ref(this),e.self());
             }
             
-            Matrix<T,N,M> &operator +=(Matrix<T,N,M> &m) {
+            constexpr Matrix<T,N,M> &operator +=(const Matrix<T,N,M> &m) {
                 for(int i=0;i<N;++i)
                     array[i]+=m[i];
                 return *this;
             }
-            
-            Matrix<T,N,M> operator -(const Matrix<T,N,M> m) const {
-                Matrix<T,N,M> res;
+
+            template<typename E>
+            constexpr Matrix<T,N,M> &operator +=(const MatExpr<E,T,N,M> &e) {
                 for(int i=0;i<N;++i)
-                    res[i]=array[i]-m[i];
-                return res;
+                    for(int j=0;j<M;++j)
+                        array[i][j]+=e.self()(i,j);
+                return *this;
+            }
+            
+            constexpr MatBinary<OpSub,Ref,Ref,T,N,M> operator -(const Matrix<T,N,M> &m) const {
+                return MatBinary<OpSub,Ref,Ref,T,N,M>(Ref(this),Ref(&m));
+            }
+
+            template<typename E>
+            constexpr MatBinary<OpSub,Ref,E,T,N,M> operator -(const MatExpr<E,T,N,M> &e) const {
+                return MatBinary<OpSub,Ref,E,T,N,M>(Ref(this),e.self());
             }
             
-            Matrix<T,N,M> &operator -=(Matrix<T,N,M> &m) {
+            constexpr Matrix<T,N,M> &operator -=(const Matrix<T,N,M> &m) {
                 for(int i=0;i<N;++i)
                     array[i]-=m[i];
                 return *this;
             }
-            
-            Matrix<T,N,M> operator *(float s) {
-                Matrix<T,N,M> res;
+
+            template<typename E>
+            constexpr Matrix<T,N,M> &operator -=(const MatExpr<E,T,N,M> &e) {
                 for(int i=0;i<N;++i)
                     for(int j=0;j<M;++j)
-                        res[i][j]=at(i,j)*s;
-                return res;
+                        array[i][j]-=e.self()(i,j);
+                return *this;
+            }
+            
+            constexpr MatScalar<OpMul,Ref,T,N,M> operator *(float s) const {
+                return MatScalar<OpMul,Ref,T,N,M>(Ref(this),s);
             }
             
             template<typename U,int V,int W>
-            friend Matrix<U,V,W> operator *(Matrix<U,V,W> m,float s);
+            friend constexpr MatScalar<OpMul,MatRef<U,V,W>,U,V,W> operator *(U s,const Matrix<U,V,W> &m);
             
-            Vector<T,N> operator *(const Vector<T,N> v) const {
-                Vector<T,N> res;
+            constexpr Vector<T,N> operator *(const Vector<T,N> v) const {
+                Vector<T,N> res(uninit);
+                if(v.is_null()||is_null()) {
+                    for(int i=0;i<N;++i)
+                        res[i]=v.dot(array[i]);
+                    return res;
+                }
+                const T *rows[N];
                 for(int i=0;i<N;++i)
-                    res[i]=v.dot(array[i]);
+                    rows[i]=array[i].data();
+                if(std::is_constant_evaluated()) simd::Scalar<T,N>::matvec(rows,v.data(),res.data());
+                else simd::Kernels<T,N>::matvec(rows,v.data(),res.data());
                 return res;
             }
             
             template<int W>
-            Matrix<T,N,W> operator *(const Matrix<T,M,W> m) const {
-                Matrix<T,N,W> res;
-                T tmp;
-                for(int i=0;i<N;++i)
-                    for(int j=0;j<W;++j) {
-                        tmp=0;
-                        for(int k=0;k<M;++k)
-                            tmp+=at(i,k)*m.at(k,j);
-                        res[i][j]=tmp;
-                    }
+            constexpr Matrix<T,N,W> operator *(const Matrix<T,M,W> m) const {
+                Matrix<T,N,W> res(uninit);
+                const T *a[N],*b[M];
+                T *r[N];
+                for(int i=0;i<N;++i) {
+                    a[i]=array[i].data();
+                    r[i]=res[i].data();
+                }
+                for(int k=0;k<M;++k)
+                    b[k]=m[k].data();
+                if(std::is_constant_evaluated()) simd::ScalarMatMul<T,N,M,W>::run(a,b,r);
+                else simd::MatMul<T,N,M,W>::run(a,b,r);
                 return res;
             }
 
-            Matrix<T,N,M> operator *=(float s) {
-                Matrix<T,N,M> res;
+            constexpr Matrix<T,N,M> &operator *=(float s) {
                 for(int i=0;i<N;++i)
-                    for(int j=0;j<M;++j)
-                        res[i][j]=at(i,j)*s;
-                (*this)=res;
+                    array[i]*=s;
                 return *this;
             }
 
@@ -218,37 +357,22 @@ namespace libmatrix {
 
             template<int W>
             Matrix<T,N,W> &operator *=(Matrix<T,M,W> &m) {
-                Matrix<T,N,W> res;
-                T tmp;
-                for(int i=0;i<N;++i)
-                    for(int j=0;j<W;++j) {
-                        tmp=0;
-                        for(int k=0;k<M;++k)
-                            tmp+=array[i][k]*m[k][j];
-                        res[i][j]=tmp;
-                    }
-                (*this)=res;
+                (*this)=(*this)*m;
                 return *this;
             }
 
-            bool operator==(const Matrix<T,N,M> &m) const {
-                for(int i=0;i<N;++i)
-                    for(int j=0;j<M;++j)
-                        if(at(i,j)!=m.at(i,j))
-                            return false;
-                return true;
+            constexpr bool operator==(const Matrix<T,N,M> &m) const {
+                return unroll_all<N>([&](int i) { return array[i]==m.array[i]; });
             }
 
-            bool operator!=(const Matrix<T,N,M> &m) const {
+            constexpr bool operator!=(const Matrix<T,N,M> &m) const {
                 return !((*this)==m);
             }
-            
-            ~Matrix(){}
     };
 
     template <typename T, int N, int M>
-    Matrix<T,N,M> operator *(Matrix<T,N,M> m,T s){
-        return s*m;
+    constexpr MatScalar<OpMul,MatRef<T,N,M>,T,N,M> operator *(T s,const Matrix<T,N,M> &m){
+        return m*s;
     }
 
     template <typename T, int N, int M>
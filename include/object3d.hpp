@@ -3,70 +3,482 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <thread>
+#include "aligned.hpp"
 #include "point.hpp"
 #include "triangle.hpp"
 #include "sphere.hpp"
+#include "plane.hpp"
+#include "aabb.hpp"
+#include "ray.hpp"
+#include "bvh.hpp"
+#include "transform.hpp"
+#include "affine.hpp"
+#include "trs.hpp"
+
+using namespace libgeometry;
 
 #define OFFSET 0.5f
 
 class Object3D {
+    public:
+        static constexpr uint32_t NO_FACE=UINT32_MAX; // missing face of an edge on the boundary of the mesh
+        static constexpr size_t MIN_PARALLEL_EDGES=1<<16; // edges tested per thread by feature_edges, at least
+
+        // Edge between the vertices v0<v1, shared by the faces faces[0] and faces[1] (faces[1] is NO_FACE if only
+        // one face has it).
+        struct Edge {
+            uint32_t v0,v1;
+            uint32_t faces[2];
+        };
+
     private:
         std::string name;
-        Point<float,4> position;
-        std::vector<Point<float,4>> vertices;
-        std::vector<Triangle<float,4>> faces;
+        TRS<float> transform; // model transform, its matrix is cached
+        unsigned long version; // changed each time the object moves or its bounds change
+        // Coordinates of the vertices, one array per axis (x, y and z) aligned on a cache line, so that the loops
+        // over the vertices stream them with SIMD loads and no w is stored.
+        aligned_vector<float> coords[3];
+        // Three indices of vertices per face, on 16 bits while every vertex fits, then on 32 bits.
+        std::vector<uint16_t> short_indices;
+        std::vector<uint32_t> indices;
+        bool wide; // true when the indices are on 32 bits
+        // Plane of each face: unit normal (one array per axis) and distance, so that nx*x+ny*y+nz*z+d is the
+        // signed distance of a point to it. The normal is the one of Triangle::normale, pointing inside the object.
+        aligned_vector<float> normals[3],distances;
+        BVH<float> hierarchy; // hierarchy of the faces in object space, empty until build_hierarchy is called
+        std::vector<Edge> edges; // edges of the faces, each once, empty until build_edges is called
+        std::vector<uint32_t> face_edges; // the 3 edges of each face, in the order of its vertices
+        std::vector<unsigned char> creases; // 1 for the boundary edges and the creases, empty until build_creases
+        AABB<float> bounds; // box of the vertices in object space
+        Sphere<float,4> sphere; // sphere containing the vertices in object space, null without vertex
+
+        // Grows the sphere so that it contains the point given as argument (step of Ritter's algorithm): the new
+        // sphere is the smallest one containing the former sphere and the point.
+        void grow_sphere(const Point<float,4> &p) {
+            if(sphere.is_null()) {
+                sphere=Sphere<float,4>(p,0);
+                return;
+            }
+            Direction<float,4> d=sphere.getCenter().length_to(p);
+            float dist=d.norm(),r=sphere.getRadius();
+            if(dist<=r) return;
+            float new_r=(r+dist)/2;
+            sphere=Sphere<float,4>(Point<float,4>(((dist-new_r)/dist)*d+sphere.getCenter()),new_r);
+        }
+
+        // Returns the vertex the farthest from the point given as argument.
+        Point<float,4> farthest(const Point<float,4> &p) const {
+            const float *x=coords[0].data(),*y=coords[1].data(),*z=coords[2].data();
+            size_t res=0;
+            float max=-1;
+            for(size_t i=0;i<coords[0].size();++i) {
+                float dx=x[i]-p.x(),dy=y[i]-p.y(),dz=z[i]-p.z();
+                float dist=(dx*dx+dy*dy)+dz*dz;
+                if(dist>max) {
+                    max=dist;
+                    res=i;
+                }
+            }
+            return vertex(res);
+        }
+
+        // Stores the indices on 32 bits from now on.
+        void widen() {
+            indices.assign(short_indices.begin(),short_indices.end());
+            short_indices.clear();
+            short_indices.shrink_to_fit();
+            wide=true;
+        }
+
+        // Sets the i-th index of the index buffer.
+        inline void set_index(size_t i, uint32_t v) {
+            if(wide) indices[i]=v;
+            else short_indices[i]=v;
+        }
+
+        // Drops what was built from the faces after they changed.
+        void faces_changed() {
+            hierarchy=BVH<float>();
+            edges.clear();
+            face_edges.clear();
+            creases.clear();
+        }
+
+        // Appends to out the feature edges among the edges [first,last) (see feature_edges).
+        void feature_edges(const Vector<float,3> &eye, size_t first, size_t last, std::vector<uint32_t> &out) const {
+            for(size_t i=first;i<last;++i) {
+                const Edge &e=edges[i];
+                bool front0=faces(e.faces[0],eye);
+                bool front1=(e.faces[1]!=NO_FACE)&&faces(e.faces[1],eye);
+                bool silhouette=(e.faces[1]!=NO_FACE)&&(front0!=front1);
+                if(silhouette||(creases[i]&&(front0||front1))) out.push_back(i);
+            }
+        }
+
+        // Appends the plane of the face of vertices i1, i2 and i3 to the planes of the faces.
+        void add_plane(uint32_t i1, uint32_t i2, uint32_t i3) {
+            const float *x=coords[0].data(),*y=coords[1].data(),*z=coords[2].data();
+            float e1[3]={x[i2]-x[i1],y[i2]-y[i1],z[i2]-z[i1]},e2[3]={x[i3]-x[i1],y[i3]-y[i1],z[i3]-z[i1]};
+            float n[3]={e1[1]*e2[2]-e1[2]*e2[1],e1[2]*e2[0]-e1[0]*e2[2],e1[0]*e2[1]-e1[1]*e2[0]};
+            float len=sqrtf((n[0]*n[0]+n[1]*n[1])+n[2]*n[2]);
+            // a degenerate face gets a null normal, and is never facing the camera
+            float inv=(len>0)?1/len:0;
+            for(int k=0;k<3;++k)
+                normals[k].push_back(n[k]*inv);
+            distances.push_back(-((normals[0].back()*x[i1]+normals[1].back()*y[i1])+normals[2].back()*z[i1]));
+        }
+
+        // Returns the axis-aligned box of a triangle.
+        static AABB<float> box(const Triangle<float,4> &t) {
+            AABB<float> res;
+            res.grow(Vector<float,3>{t.get_p0().x(),t.get_p0().y(),t.get_p0().z()});
+            res.grow(Vector<float,3>{t.get_p1().x(),t.get_p1().y(),t.get_p1().z()});
+            res.grow(Vector<float,3>{t.get_p2().x(),t.get_p2().y(),t.get_p2().z()});
+            return res;
+        }
 
     public:
-        Object3D(int x=0,int y=0, int z=0) {
-            position=Point<float,4>{x*OFFSET,y*OFFSET,z*OFFSET};
+        Object3D(int x=0,int y=0, int z=0) : transform(Vec3r{x*OFFSET,y*OFFSET,z*OFFSET}), version(0), wide(false) {}
+
+        // Returns the bounding sphere, in world space.
+        Sphere<float,4> bsphere() const {
+            if(sphere.is_null()) return sphere;
+            Point<float,4> center=getAffine().apply(sphere.getCenter());
+            return Sphere<float,4>(center,sphere.getRadius()*fabs(transform.get_scale()));
+        }
+
+        // Returns the bounding sphere, in object space (null if the object has no vertex).
+        inline const Sphere<float,4> &local_bsphere() const { return sphere; }
+
+        // Returns the axis-aligned bounding box of the vertices, in object space.
+        inline const AABB<float> &bbox() const { return bounds; }
+
+        // Recomputes the bounding volumes from all the vertices. The box is exact, and the sphere given by
+        // Ritter's algorithm: from the two vertices the farthest apart along a first sweep, then grown to
+        // contain every vertex. Adding vertices one by one grows the volumes without sweeping them again,
+        // but the sphere is looser than the one computed here: fit_bounds can be called once they are loaded.
+        void fit_bounds() {
+            ++version;
+            bounds=AABB<float>();
+            sphere=Sphere<float,4>();
+            size_t n=coords[0].size();
+            if(n==0) return;
+            Vector<float,3> low(uninit),high(uninit);
+            for(int k=0;k<3;++k) {
+                const float *c=coords[k].data();
+                float lo=c[0],hi=c[0];
+                for(size_t i=1;i<n;++i) {
+                    lo=fmin(lo,c[i]);
+                    hi=fmax(hi,c[i]);
+                }
+                low[k]=lo;
+                high[k]=hi;
+            }
+            bounds=AABB<float>(low,high);
+            Point<float,4> p1=farthest(vertex(0));
+            Point<float,4> p2=farthest(p1);
+            Direction<float,4> d=p1.length_to(p2);
+            sphere=Sphere<float,4>(Point<float,4>(0.5f*d+p1),d.norm()/2);
+            for(size_t i=0;i<n;++i)
+                grow_sphere(vertex(i));
+        }
+
+        // Returns the volume of the bounding sphere relative to the one of the bounding box, to measure how
+        // tight the sphere is. It is at least pi/6 (about 0.52), reached by round objects whose sphere fits inside
+        // their box, is sqrt(3)*pi/2 (about 2.72) for the corners of a cube, whose sphere is circumscribed, and
+        // grows for elongated objects. Returns infinity if the box is flat.
+        float sphere_tightness() const {
+            if(sphere.is_null()) return 0;
+            Vector<float,3> e=bounds.extents();
+            float r=sphere.getRadius();
+            return ((4*M_PI/3)*r*r*r)/(8*e[0]*e[1]*e[2]);
         }
 
-        // Returns the bounding sphere.
-        Sphere<float,4> bsphere() {
-            float tmp,max=0;
-            for(size_t i=0;i<vertices.size();++i) {
-                tmp=(position.length_to(vertices[i])).norm();
-                if(tmp>max) max=tmp;
+        // Returns an axis-aligned box containing the object, in world space: the box of the transformed box,
+        // cut by the box of the bounding sphere, which is tighter for rotated objects.
+        AABB<float> world_bbox() const {
+            AABB<float> res=getAffine().apply(bounds);
+            Sphere<float,4> s=bsphere();
+            if(s.is_null()) return res;
+            Vector<float,3> low=res.get_low(),high=res.get_high();
+            for(int i=0;i<3;++i) {
+                low[i]=fmax(low[i],s.getCenter()[i]-s.getRadius());
+                high[i]=fmin(high[i],s.getCenter()[i]+s.getRadius());
             }
-            return Sphere<float,4>(position,max);
+            return AABB<float>(low,high);
         }
 
-        // Returns the n-th face of the object, where n is given as argument.
+        // Returns the n-th face of the object, where n is given as argument, built from its vertices.
         Triangle<float,4> face(unsigned int n) const {
-            if(n<faces.size()) return faces[n];
+            if(n<num_faces()) return Triangle<float,4>(vertex(index(n,0)),vertex(index(n,1)),vertex(index(n,2)));
             return Triangle<float,4>();
         }
 
+        // Returns the index of the k-th vertex (0, 1 or 2) of the n-th face.
+        inline uint32_t index(unsigned int n, int k) const {
+            return wide?indices[3*n+k]:short_indices[3*n+k];
+        }
+
         // Returns the number of faces of the object.
         unsigned int num_faces() const {
-            return faces.size();
+            return (wide?indices.size():short_indices.size())/3;
+        }
+
+        // Returns the plane of the n-th face: its unit normal (pointing inside the object, as Triangle::normale)
+        // and its distance, so that p.dot(plane) is the signed distance of a point p to it.
+        Plane<float,4> plane(unsigned int n) const {
+            return Plane<float,4>(Vector<float,4>{normals[0][n],normals[1][n],normals[2][n],distances[n]});
+        }
+
+        // Returns true if the n-th face is facing the point given as argument (in object space, usually the
+        // camera), that is if the point is on the outer side of its plane.
+        inline bool faces(unsigned int n, const Vector<float,3> &eye) const {
+            return ((normals[0][n]*eye[0]+normals[1][n]*eye[1])+normals[2][n]*eye[2])+distances[n]<0;
         }
 
-        // Adds a face to the object. The three integers given as arguments correspond to three vertices.
-        void add_face(unsigned int i1, unsigned int i2, unsigned int i3) {
-            faces.push_back(Triangle<float,4>(vertices[i1],vertices[i2],vertices[i3]));
+        // Returns the i-th vertex of the object, which the faces refer to by index.
+        inline Point<float,4> vertex(size_t i) const {
+            return Point<float,4>{coords[0][i],coords[1][i],coords[2][i]};
+        }
+
+        // Returns the array of the coordinates of the vertices along the axis given as argument (0 for x, 1 for y
+        // and 2 for z), aligned on 64 bytes.
+        inline const float *get_coords(int axis) const { return coords[axis].data(); }
+
+        // Returns the number of vertices of the object.
+        inline unsigned int num_vertices() const { return coords[0].size(); }
+
+        // Returns the number of bytes taken by the vertices, the indices and the planes of the faces, and the edges.
+        size_t mesh_bytes() const {
+            return 3*coords[0].size()*sizeof(float)+short_indices.size()*sizeof(uint16_t)+indices.size()*sizeof(uint32_t)+
+                   4*distances.size()*sizeof(float)+edges.size()*sizeof(Edge)+face_edges.size()*sizeof(uint32_t)+creases.size();
+        }
+
+        // Adds a face to the object. The three integers given as arguments correspond to three vertices, which must
+        // already be added: the plane of the face is computed from them. Returns false, without adding the face, if
+        // one of them is not a vertex of the object.
+        bool add_face(unsigned int i1, unsigned int i2, unsigned int i3) {
+            size_t n=num_vertices();
+            if(i1>=n||i2>=n||i3>=n) return false;
+            if(!wide&&(i1>UINT16_MAX||i2>UINT16_MAX||i3>UINT16_MAX)) widen();
+            if(wide) indices.insert(indices.end(),{i1,i2,i3});
+            else short_indices.insert(short_indices.end(),{(uint16_t)i1,(uint16_t)i2,(uint16_t)i3});
+            add_plane(i1,i2,i3);
+            faces_changed();
+            return true;
         }
 
         // Deletes a face from the object. The integer given as argument refers to the list of faces.
         void remove_face(unsigned int i) {
-            faces.erase(faces.begin()+i);
+            if(wide) indices.erase(indices.begin()+3*i,indices.begin()+3*i+3);
+            else short_indices.erase(short_indices.begin()+3*i,short_indices.begin()+3*i+3);
+            for(int k=0;k<3;++k)
+                normals[k].erase(normals[k].begin()+i);
+            distances.erase(distances.begin()+i);
+            faces_changed();
+        }
+
+        // Builds the hierarchy of the faces, once they are all added: changing the faces drops it.
+        void build_hierarchy() {
+            std::vector<AABB<float>> boxes(num_faces());
+            for(size_t i=0;i<boxes.size();++i)
+                boxes[i]=box(face(i));
+            hierarchy.build(boxes.data(),boxes.size());
+        }
+
+        // Builds the table of the edges, once the faces are all added: changing the faces drops it, and building it
+        // again drops the marks of build_creases. The edges are found through a hash table on their pair of
+        // vertices. An edge shared by more than two faces is split into several entries, so that each entry keeps
+        // at most two faces.
+        void build_edges() {
+            edges.clear();
+            creases.clear();
+            face_edges.resize(3*num_faces());
+            std::unordered_map<uint64_t,uint32_t> found; // entry of each pair of vertices having a free face
+            found.reserve(3*num_faces()/2);
+            for(uint32_t f=0;f<num_faces();++f)
+                for(int k=0;k<3;++k) {
+                    uint32_t v0=index(f,k),v1=index(f,(k+1)%3);
+                    if(v0>v1) std::swap(v0,v1);
+                    uint64_t key=((uint64_t)v0<<32)|v1;
+                    auto it=found.find(key);
+                    if(it==found.end()) {
+                        found.emplace(key,edges.size());
+                        face_edges[3*f+k]=edges.size();
+                        edges.push_back(Edge{v0,v1,{f,NO_FACE}});
+                    } else {
+                        face_edges[3*f+k]=it->second;
+                        edges[it->second].faces[1]=f;
+                        found.erase(it);
+                    }
+                }
+        }
+
+        // Returns the edges of the faces (none if build_edges was not called).
+        inline const std::vector<Edge> &get_edges() const { return edges; }
+
+        // Returns the index of the k-th edge of the n-th face in get_edges, the one from its k-th vertex to the next.
+        inline uint32_t edge(unsigned int n, int k) const { return face_edges[3*n+k]; }
+
+        // Calls visit(v0,v1) once for each edge of the n faces given as argument, for instance the ones facing the
+        // camera: an edge shared by two of them is visited by the one of lowest index only. flags must hold a 0 per
+        // face (it is resized if needed), and is left that way. Needs the table of build_edges.
+        template<typename Visit>
+        void visit_edges(const uint32_t *selected, size_t n, std::vector<unsigned char> &flags, Visit visit) const {
+            flags.resize(num_faces(),0);
+            for(size_t i=0;i<n;++i)
+                flags[selected[i]]=1;
+            for(size_t i=0;i<n;++i) {
+                uint32_t f=selected[i];
+                for(int k=0;k<3;++k) {
+                    const Edge &e=edges[face_edges[3*f+k]];
+                    uint32_t other=(e.faces[0]==f)?e.faces[1]:e.faces[0];
+                    if(other==NO_FACE||!flags[other]||f<other) visit(e.v0,e.v1);
+                }
+            }
+            for(size_t i=0;i<n;++i)
+                flags[selected[i]]=0;
+        }
+
+        // Marks the boundary edges (with a single face) and the creases, whose faces make an angle above the one
+        // given as argument (in degrees) between their normales, so that feature_edges can select them. Builds the
+        // table of the edges first if needed. Changing the faces drops the marks.
+        void build_creases(float angle) {
+            if(edges.empty()) build_edges();
+            float min_cos=cosf((angle*M_PI)/180);
+            creases.resize(edges.size());
+            for(size_t i=0;i<edges.size();++i) {
+                uint32_t f0=edges[i].faces[0],f1=edges[i].faces[1];
+                if(f1==NO_FACE) creases[i]=1;
+                else creases[i]=((normals[0][f0]*normals[0][f1]+normals[1][f0]*normals[1][f1])+normals[2][f0]*normals[2][f1])<min_cos;
+            }
+        }
+
+        // Returns true if build_creases was called since the faces last changed.
+        inline bool has_creases() const { return !creases.empty(); }
+
+        // Returns the number of edges marked by build_creases.
+        size_t num_creases() const {
+            size_t res=0;
+            for(size_t i=0;i<creases.size();++i)
+                res+=creases[i];
+            return res;
+        }
+
+        // Stores in out the indices (in get_edges) of the feature edges seen from the point given as argument (in
+        // object space, usually the camera): the silhouette, between a face facing it and one turned away, and the
+        // boundary edges and creases marked by build_creases with a face facing it. The edges are split into ranges
+        // tested on up to threads threads, when there are enough of them. Needs build_creases.
+        void feature_edges(const Vector<float,3> &eye, std::vector<uint32_t> &out,
+                           unsigned int threads=std::thread::hardware_concurrency()) const {
+            out.clear();
+            size_t n=creases.size(),ranges=n/MIN_PARALLEL_EDGES;
+            if(threads>ranges) threads=ranges;
+            if(threads<=1) {
+                feature_edges(eye,0,n,out);
+                return;
+            }
+            // the ranges are appended in order, so that the result does not depend on the number of threads
+            std::vector<std::vector<uint32_t>> parts(threads-1);
+            std::vector<std::thread> workers;
+            for(unsigned int t=1;t<threads;++t)
+                workers.emplace_back([&,t]() { feature_edges(eye,n*t/threads,n*(t+1)/threads,parts[t-1]); });
+            feature_edges(eye,0,n/threads,out);
+            for(unsigned int t=1;t<threads;++t) {
+                workers[t-1].join();
+                out.insert(out.end(),parts[t-1].begin(),parts[t-1].end());
+            }
+        }
+
+        // Returns the hierarchy of the faces in object space (with no node if it was not built).
+        inline const BVH<float> &get_hierarchy() const { return hierarchy; }
+
+        // Returns true if the ray given as argument (in object space) hits a face, and then stores the parameter
+        // of the closest hit in t and the index of its face in face. Without hierarchy, every face is tested.
+        bool raycast(const Ray<float> &r, float &t, unsigned int &face) const {
+            float best=std::numeric_limits<float>::infinity();
+            auto hit=[&](uint32_t i) {
+                float ti;
+                if(r.hits(this->face(i),ti)&&ti<best) {
+                    best=ti;
+                    face=i;
+                }
+            };
+            if(hierarchy.size()==0) {
+                for(uint32_t i=0;i<num_faces();++i)
+                    hit(i);
+            } else {
+                // the nodes behind the closest hit found so far are skipped
+                hierarchy.traverse(0,[&](uint32_t, const AABB<float> &b, int &) {
+                    return r.hits(b,best)?OVERLAPPING:DISJOINT;
+                },hit);
+            }
+            if(best==std::numeric_limits<float>::infinity()) return false;
+            t=best;
+            return true;
         }
 
         // Adds a vertex to the object. The three float given as arguments correspond to the coordinates of the vertex.
+        // The bounding volumes grow to contain it.
         void add_vertex(float f1, float f2, float f3) {
-            vertices.push_back(Point<float,4>{f1,f2,f3});
+            coords[0].push_back(f1);
+            coords[1].push_back(f2);
+            coords[2].push_back(f3);
+            bounds.grow(Vector<float,3>{f1,f2,f3});
+            ++version;
+            grow_sphere(Point<float,4>{f1,f2,f3});
         }
 
         // Deletes a vertex from the object. The integer given as argument refers to the list of vertices.
+        // The faces using it are deleted too, and the bounding volumes are computed again.
         void remove_vertex(unsigned int i) {
-            for(size_t j=0;j<faces.size();++j)
-                if(faces[j].get_p0()==vertices[i]||faces[j].get_p1()==vertices[i]||faces[j].get_p2()==vertices[i])
-                    faces.erase(faces.begin()+j);
-            vertices.erase(vertices.begin()+i);
+            size_t kept=0;
+            for(unsigned int f=0;f<num_faces();++f) {
+                uint32_t v[3]={index(f,0),index(f,1),index(f,2)};
+                if(v[0]==i||v[1]==i||v[2]==i) continue;
+                for(int k=0;k<3;++k) {
+                    normals[k][kept/3]=normals[k][f];
+                    set_index(kept++,(v[k]>i)?v[k]-1:v[k]);
+                }
+                distances[kept/3-1]=distances[f];
+            }
+            if(wide) indices.resize(kept);
+            else short_indices.resize(kept);
+            for(int k=0;k<3;++k)
+                normals[k].resize(kept/3);
+            distances.resize(kept/3);
+            for(int k=0;k<3;++k)
+                coords[k].erase(coords[k].begin()+i);
+            faces_changed();
+            fit_bounds();
         }
 
+        // Returns the position of the object.
+        inline Point<float,4> get_position() const { return Point<float,4>(transform.get_translation()); }
+
+        // Moves the object to the position given as argument.
+        inline void set_position(float x, float y, float z) { transform.set_translation(Vec3r{x,y,z}); ++version; }
+
+        // Sets the rotation of the object.
+        inline void set_rotation(const Quaternion<float> &q) { transform.set_rotation(q); ++version; }
+
+        // Sets the (uniform) scale of the object.
+        inline void set_scale(float s) { transform.set_scale(s); ++version; }
+
+        // Returns a number changed each time the object moves or its bounds change, so that the world box kept by a
+        // scene can be checked without relying on the cache of the matrix, which any reader of it clears.
+        inline unsigned long get_version() const { return version; }
+
+        // Returns the model transform, kept as translation, rotation and scale.
+        inline const TRS<float> &getTRS() const { return transform; }
+
+        // Returns the model matrix, only recomputed after the object moved.
+        inline const Affine3<float> &getAffine() const { return transform.affine(); }
+
         // Returns the model matrix.
-        inline Transform<float> getTransform() const {return Transform<float>(Vec3r{position.at(0),position.at(1),position.at(2)});}
+        inline Transform<float> getTransform() const { return transform.transform(); }
 
         ~Object3D() {}
 };
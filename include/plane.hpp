@@ -13,11 +13,16 @@ namespace libgeometry {
     class Plane : public Vector<T,N> {
         public:
             Plane(){}
-            Plane(Vector<T,N> v) {
-                v=v.to_unit();
-                for(int i=0;i<N;++i) this->array[i]=v[i];
+            // Plane of equation v[0]*x+v[1]*y+...+v[N-1]=0, scaled so that its normal is a unit vector: the
+            // dot product with a point (whose last coordinate is 1) is then the signed distance to the plane.
+            // Without normal (the plane of a degenerate face), all its coordinates are 0, as the normale of the face.
+            Plane(Vector<T,N> v) : Vector<T,N>(zero) {
+                T n=0;
+                for(int i=0;i<N-1;++i) n+=v[i]*v[i];
+                if(n==0) return;
+                n=sqrt(n);
+                for(int i=0;i<N;++i) this->array[i]=v[i]/n;
             }
-            ~Plane(){}
     };
 }
 
@@ -20,22 +20,27 @@ namespace libgeometry {
     template <typename T, int N>    
     class Point : public Vector<T,N> {
         public:
-            Point() {
+            constexpr Point() {
                 this->array[N-1]=1;
             }
 
-            Point(const Vector<T,N> v) {
+            constexpr explicit Point(uninit_t u) : Vector<T,N>(u) {}
+
+            constexpr Point(const Vector<T,N> v) : Vector<T,N>(uninit) {
                 for(int i=0;i<N;++i)
                     this->array[i]=v.at(i);
             }
 
-            Point(const Vector<T,N-1> v) {
+            template<typename E>
+            constexpr Point(const VecExpr<E,T,N> &e) : Vector<T,N>(e) {}
+
+            constexpr Point(const Vector<T,N-1> v) : Vector<T,N>(uninit) {
                 for(int i=0;i<N-1;++i)
                     this->array[i]=v.at(i);
                 this->array[N-1]=1;
             }
 
-            Point(std::initializer_list<T> l) {
+            constexpr Point(std::initializer_list<T> l) {
                 for(size_t i=0;i<l.size();++i)
                     this->array[i]=l.begin()[i];
                 this->array[N-1]=1;
@@ -75,8 +80,6 @@ namespace libgeometry {
                 res[3]=tmp.at(3);
                 return res;
             }
-
-            ~Point() {}
     };
 }
 
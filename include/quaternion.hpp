@@ -4,6 +4,7 @@
 #include <iostream>
 #include <math.h>
 #include "direction.hpp"
+#include "constmath.hpp"
 #include "libmatrix.h"
 
 namespace libgeometry {
@@ -13,19 +14,21 @@ namespace libgeometry {
     class Quaternion : public Vector<T,4> {
 
         public:
-            Quaternion(std::initializer_list<T> l) : Vector<T,4>(l){}
+            constexpr Quaternion(std::initializer_list<T> l) : Vector<T,4>(l){}
 
-            Quaternion(T angle,Direction<T,4> axis) {
+            // Rotation of angle degrees around axis. Can be computed at compile time.
+            constexpr Quaternion(T angle,Direction<T,4> axis) : Vector<T,4>(uninit) {
                 angle=((angle*M_PI)/180)/2;
-                this->array[0]=axis.at(0)*sin(angle);
-                this->array[1]=axis.at(1)*sin(angle);
-                this->array[2]=axis.at(2)*sin(angle);
-                this->array[3]=cos(angle);
+                T s=constmath::sin(angle);
+                this->array[0]=axis.at(0)*s;
+                this->array[1]=axis.at(1)*s;
+                this->array[2]=axis.at(2)*s;
+                this->array[3]=constmath::cos(angle);
             }
 
             // Returns the conjugate of the quaternion.
-            inline Quaternion<T> conjugate() const { 
-                Quaternion<T> c;
+            constexpr Quaternion<T> conjugate() const { 
+                Quaternion<T> c(uninit);
                 c[0]=-this->at(0);
                 c[1]=-this->at(1);
                 c[2]=-this->at(2);
@@ -34,8 +37,8 @@ namespace libgeometry {
             }
             
             // Returns the imaginary part of the quaternion.
-            inline Vector<T,3> im() const {
-                Vector<T,3> i;
+            constexpr Vector<T,3> im() const {
+                Vector<T,3> i(uninit);
                 i[0]=this->at(0);
                 i[1]=this->at(1);
                 i[2]=this->at(2);
@@ -45,13 +48,15 @@ namespace libgeometry {
             // Returns the inverse of the quaternion.
             inline Quaternion<T> inverse() const {
                 T n=this->norm();
-                return (1/(n*n))*conjugate();
+                Quaternion<T> c=conjugate();
+                c*=1/(n*n);
+                return c;
             }
 
             // Returns the real part of the quaternion.
-            inline float re() const { return this->at(3); }
+            constexpr float re() const { return this->at(3); }
 
-            Quaternion<T> operator+(float s) { 
+            constexpr Quaternion<T> operator+(float s) { 
                 Quaternion<T> q=*this;
                 for(int i=0;i<4;++i)
                     q[i]+=s;
@@ -61,14 +66,14 @@ namespace libgeometry {
             template<typename U>
             friend Quaternion<U> operator+(U s,Quaternion<U> &q);
 
-            Quaternion<T> operator+(Quaternion<T> q1) {
+            constexpr Quaternion<T> operator+(Quaternion<T> q1) {
                 Quaternion<T> q2=*this;
                 for(int i=0;i<4;++i)
                     q2[i]+=q1[i];
                 return q2;
             }
 
-            Quaternion<T> &operator+=(T s) {
+            constexpr Quaternion<T> &operator+=(T s) {
                 for(int i=0;i<4;++i)
                     this->array[i]+=s;
                 return *this;
@@ -77,13 +82,13 @@ namespace libgeometry {
             template<typename U>
             friend Quaternion<U> &operator+=(U s,Quaternion<U> &q);
 
-            Quaternion<T> &operator+=(Quaternion<T> &q) {
+            constexpr Quaternion<T> &operator+=(Quaternion<T> &q) {
                 for(int i=0;i<4;++i)
                     this->array[i]+=q[i];
                 return *this;
             }
 
-            Quaternion<T> operator-(T s) {
+            constexpr Quaternion<T> operator-(T s) {
                 Quaternion<T> q=*this;
                 for(int i=0;i<4;++i)
                     q[i]-=s;
@@ -93,14 +98,14 @@ namespace libgeometry {
             template<typename U>
             friend Quaternion<U> operator-(U s,Quaternion<U> q);
 
-            Quaternion<T> operator-(Quaternion<T> q1) {
+            constexpr Quaternion<T> operator-(Quaternion<T> q1) {
                 Quaternion<T> q2=*this;
                 for(int i=0;i<4;++i)
                     q2[i]-=q1[i];
                 return q2;
             }
 
-            Quaternion<T> &operator-=(T s) {
+            constexpr Quaternion<T> &operator-=(T s) {
                 for(int i=0;i<4;++i)
                     this->array[i]-=s;
                 return *this;
@@ -109,13 +114,13 @@ namespace libgeometry {
             template<typename U>
             friend Quaternion<U> &operator -=(U s,Quaternion<U> &q);
 
-            Quaternion<T> &operator-=(Quaternion<T> &q) {
+            constexpr Quaternion<T> &operator-=(Quaternion<T> &q) {
                 for(int i=0;i<4;++i)
                     this->array[i]-=q[i];
                 return *this;
             }
 
-            Quaternion<T> operator*(T s) {
+            constexpr Quaternion<T> operator*(T s) {
                 Quaternion<T> q=*this;
                 for(int i=0;i<4;++i)
                     q[i]*=s;
@@ -125,15 +130,15 @@ namespace libgeometry {
             template<typename U>
             friend Quaternion<U> operator*(U s,Quaternion<U> q);
 
-            Quaternion<T> operator*(Quaternion<T> q2) {
+            constexpr Quaternion<T> operator*(Quaternion<T> q2) {
                 Quaternion q1=*this;
                 Vector<float,3> v1=q1.im(),v2=q2.im();
-                v1=q1.re()*v2+q2.re()*v1+v1.cross(v2);
                 T s=q1.re()*q2.re()-v1.dot(v2);
+                v1=q1.re()*v2+q2.re()*v1+v1.cross(v2);
                 return Quaternion<float>{v1[0],v1[1],v1[2],s};
             }
 
-            Quaternion<T> &operator*=(float s) {
+            constexpr Quaternion<T> &operator*=(float s) {
                 for(int i=0;i<4;++i)
                     this->array[i]*=s;
                 return *this;
@@ -142,12 +147,14 @@ namespace libgeometry {
             template<typename U>
             friend Quaternion<U> &operator *=(U s,Quaternion<U> &q);
 
-            Quaternion<T> &operator*=(Quaternion<T> q) {
+            constexpr Quaternion<T> &operator*=(Quaternion<T> q) {
                 *this=(*this)*q;
                 return *this;
             }
 
-            Quaternion(){}
+            constexpr Quaternion(){}
+
+            constexpr explicit Quaternion(uninit_t u) : Vector<T,4>(u) {}
     };
 
     template <typename T>
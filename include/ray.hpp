@@ -0,0 +1,79 @@
+#ifndef RAY_HPP
+#define RAY_HPP
+
+#include <iostream>
+#include <math.h>
+#include "vector.hpp"
+#include "point.hpp"
+#include "triangle.hpp"
+#include "aabb.hpp"
+
+namespace libgeometry {
+
+    // Half-line starting at origin and going towards direction, whose points are origin+t*direction for t>=0.
+    // The direction does not need to be a unit vector: t is then not a distance, but it is kept by affine
+    // transforms, so that a ray can be moved to object space and its hits compared with the ones of other objects.
+    template<typename T>
+    class Ray {
+        private:
+            Vector<T,3> origin,direction;
+            Vector<T,3> inv_direction; // 1/direction, for the box tests
+
+        public:
+            Ray(const Vector<T,3> &o, const Vector<T,3> &d) : origin(o), direction(d) {
+                for(int i=0;i<3;++i)
+                    inv_direction[i]=1/d[i];
+            }
+
+            inline const Vector<T,3> &get_origin() const { return origin; }
+            inline const Vector<T,3> &get_direction() const { return direction; }
+
+            // Returns the point of parameter t.
+            Vector<T,3> at(T t) const {
+                return Vector<T,3>{origin[0]+t*direction[0],origin[1]+t*direction[1],origin[2]+t*direction[2]};
+            }
+
+            // Returns true if the ray enters the box given as argument before the parameter tmax (slab test).
+            bool hits(const AABB<T> &b, T tmax) const {
+                T tmin=0;
+                for(int i=0;i<3;++i) {
+                    T t1=(b.get_low()[i]-origin[i])*inv_direction[i];
+                    T t2=(b.get_high()[i]-origin[i])*inv_direction[i];
+                    // NaN (origin on a face of a slab parallel to the ray) leaves the bounds unchanged
+                    tmin=fmax(tmin,fmin(t1,t2));
+                    tmax=fmin(tmax,fmax(t1,t2));
+                }
+                return tmin<=tmax;
+            }
+
+            // Returns true if the ray hits the triangle given as argument (Möller-Trumbore), and then stores in t
+            // the parameter of the hit. Both sides of the triangle are hit.
+            bool hits(const Triangle<T,4> &tr, T &t) const {
+                Point<T,4> p0=tr.get_p0(),p1=tr.get_p1(),p2=tr.get_p2();
+                Vector<T,3> e1{p1.x()-p0.x(),p1.y()-p0.y(),p1.z()-p0.z()};
+                Vector<T,3> e2{p2.x()-p0.x(),p2.y()-p0.y(),p2.z()-p0.z()};
+                Vector<T,3> p=direction.cross(e2);
+                T det=e1.dot(p);
+                if(!(fabs(det)>0)) return false; // parallel, degenerate or invalid
+                T inv=1/det;
+                Vector<T,3> s{origin[0]-p0.x(),origin[1]-p0.y(),origin[2]-p0.z()};
+                T u=s.dot(p)*inv;
+                if(u<0||u>1) return false;
+                Vector<T,3> q=s.cross(e1);
+                T v=direction.dot(q)*inv;
+                if(v<0||u+v>1) return false;
+                T res=e2.dot(q)*inv;
+                if(res<0) return false;
+                t=res;
+                return true;
+            }
+    };
+
+    template<typename T>
+    std::ostream &operator <<(std::ostream &out, const Ray<T> &r) {
+        out << '(' << r.get_origin() << ',' << r.get_direction() << ')';
+        return out;
+    }
+}
+
+#endif
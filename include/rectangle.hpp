@@ -21,8 +21,6 @@ namespace libgeometry {
 
             template<typename U,int M>
             friend std::ostream &operator <<(std::ostream &out, const Rectangle<U,M> r);
-
-            ~Rectangle(){}
     };
 
     template<typename T,int N>
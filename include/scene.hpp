@@ -2,37 +2,132 @@
 #define SCENE_HPP
 
 #include <vector>
+#include <sstream>
 #include "scene_interface.h"
 #include "gui.h"
 #include "gui_interface.h"
 #include "camera.hpp"
 #include "object3d.hpp"
+#include "bvh.hpp"
+#include "aabb.hpp"
+#include "ray.hpp"
 #include "triangle.hpp"
 #include "point.hpp"
 
 using namespace libgeometry;
 
 class Scene : public SceneInterface {
+    public:
+        // Edges drawn: all the edges of the faces facing the camera, or only the silhouette, boundary and crease
+        // edges (see Object3D::feature_edges) of the objects where build_creases was called.
+        enum EdgeMode { ALL_EDGES, FEATURE_EDGES };
+
     private:
+        static constexpr uint32_t NO_SLOT=UINT32_MAX; // vertex not in vertex_buffer
+
         gui::Gui *gui;
         Camera camera;
         std::vector<Object3D *> objects;
+        mutable std::vector<Point<float,4>> vertex_buffer; // transformed vertices of the object being drawn
+        mutable std::vector<uint32_t> vertex_slots; // place of each vertex of the object in vertex_buffer
+        mutable std::vector<uint32_t> visible_faces; // faces of the object being drawn left by its hierarchy
+        mutable std::vector<unsigned char> face_drawn; // flags of the faces drawn, for Object3D::visit_edges
+        mutable std::vector<uint32_t> feature_list; // feature edges of the object being drawn
+        EdgeMode edge_mode;
+        BVH<float> bvh; // hierarchy of the world space boxes of the objects
+        std::vector<AABB<float>> boxes; // world space box of each object
+        std::vector<unsigned long> versions; // version of each object when its box was computed
+        bool rebuild; // true when objects were added since the hierarchy was built
+        mutable std::vector<unsigned char> last_planes; // for each node of the hierarchy, the frustum plane that rejected it last
+        mutable Frustum::CullStats cull_stats; // plane tests made to cull the objects during the last frame
 
     public:
-        Scene() {}
-        Scene(gui::Gui *g, Camera c) : gui(g), camera(c) {}
+        Scene() : edge_mode(ALL_EDGES), rebuild(false) {}
+        Scene(gui::Gui *g, Camera c) : gui(g), camera(c), edge_mode(ALL_EDGES), rebuild(false) {}
+
+        // Sets the edges drawn.
+        void set_edge_mode(EdgeMode m) {
+            edge_mode=m;
+        }
 
         // Draws all objects in the field of vision of the camera.
+        // The objects are culled through their hierarchy: the subtrees completely in the field of vision are not
+        // tested further, and the children of a node are only tested against the planes it crosses.
         virtual void draw() const {
-            Transform<float> transform=camera.get_transform();
+            last_planes.resize(bvh.size(),0);
+            cull_stats.reset();
+            bvh.traverse(Frustum::ALL_PLANES,[&](uint32_t node, const AABB<float> &box, unsigned int &mask) {
+                switch(camera.classify(box,mask,last_planes[node],&cull_stats)) {
+                    case Frustum::OUTSIDE: return DISJOINT;
+                    case Frustum::INSIDE: return CONTAINED;
+                    default: return OVERLAPPING;
+                }
+            },[&](uint32_t i) {
+                draw_object(objects[i]);
+            });
+            std::stringstream text;
+            text << plane_tests_per_object() << " plane tests/object (" << cull_stats.average() << "/node)";
+            gui->render_text({10,10},text.str(),gui::white);
+        }
+
+        // Builds the hierarchy of the objects if some were added, or refits it if some moved since their boxes
+        // were computed. The planes cached per node are dropped when the tree is built again.
+        void update_hierarchy() {
+            bool moved=false;
+            for(size_t i=0;i<versions.size()&&!moved;++i)
+                moved=(objects[i]->get_version()!=versions[i]);
+            if(!rebuild&&!moved) return;
+            boxes.resize(objects.size());
+            versions.resize(objects.size());
             for(size_t i=0;i<objects.size();++i) {
-                //Transform<float> o_transform=objects[i]->getTransform();
-                transform = transform.concat(objects[i]->getTransform());
-                Sphere<float,4> bs=transform.apply(objects[i]->bsphere());
-                //bs=transform.apply(objects[i]->bsphere());
-                if(!camera.outside_frustum(bs))
-                    draw_object(objects[i]);
+                boxes[i]=objects[i]->world_bbox();
+                versions[i]=objects[i]->get_version();
             }
+            if(rebuild) {
+                bvh.build(boxes.data(),boxes.size());
+                last_planes.assign(bvh.size(),0);
+            } else bvh.refit(boxes.data());
+            rebuild=false;
+        }
+
+        // Returns the object hit first by the ray given as argument (in world space), or nullptr if there is none.
+        // The parameter of the hit along the ray is then stored in t, and the index of the face hit in face.
+        // The objects are found through the hierarchy, then their faces through their own.
+        Object3D *raycast(const Ray<float> &r, float &t, unsigned int &face) const {
+            Object3D *res=nullptr;
+            float best=std::numeric_limits<float>::infinity();
+            bvh.traverse(0,[&](uint32_t, const AABB<float> &box, int &) {
+                return r.hits(box,best)?OVERLAPPING:DISJOINT;
+            },[&](uint32_t i) {
+                // the ray is moved to object space, where its parameters are the same
+                Affine3<float> inverse=objects[i]->getAffine().inverse();
+                const Vector<float,3> &o=r.get_origin(),&d=r.get_direction();
+                Point<float,4> origin=inverse.apply(Point<float,4>{o[0],o[1],o[2]});
+                Direction<float,4> direction=inverse.apply(Direction<float,4>{d[0],d[1],d[2]});
+                Ray<float> local(Vector<float,3>{origin.x(),origin.y(),origin.z()},
+                                 Vector<float,3>{direction.x(),direction.y(),direction.z()});
+                float ti;
+                unsigned int fi;
+                if(objects[i]->raycast(local,ti,fi)&&ti<best) {
+                    best=ti;
+                    face=fi;
+                    res=objects[i];
+                }
+            });
+            if(res) t=best;
+            return res;
+        }
+
+        // Returns the number of plane tests made to cull the nodes of the hierarchy during the last frame. Its average
+        // is per node visited, not per object as when each object was culled in turn: see plane_tests_per_object.
+        const Frustum::CullStats &get_cull_stats() const {
+            return cull_stats;
+        }
+
+        // Returns the average number of plane tests per object of the scene (drawn or culled) during the last frame,
+        // comparable with the culling of each object in turn.
+        float plane_tests_per_object() const {
+            return objects.empty()?0:(float)cull_stats.plane_tests/objects.size();
         }
 
         virtual void press_up() {camera.move_up();};
@@ -59,32 +154,122 @@ class Scene : public SceneInterface {
 
         virtual void update() {
             camera.update();
+            update_hierarchy();
             draw();
         };
 
         // Draws all sides of the object given as argument that are facing the camera.
         void draw_object(const Object3D *o) const {
-            Triangle<float,4> tmp;
-            Transform<float> o_transform=o->getTransform();
-            Transform<float> transform=o_transform.concat(camera.get_transform());
-            for(size_t i=0;i<o->num_faces();++i) {
-                Triangle<float,4> t=o->face(i);
-                tmp=Triangle<float,4>(transform.apply(t.get_p0()),transform.apply(t.get_p1()),transform.apply(t.get_p2()));
-                if(camera.sees(tmp)) draw_wire_triangle(tmp);
+            // The model matrix is affine: only the camera transform needs a full 4x4 product.
+            const Affine3<float> &model=o->getAffine();
+            Transform<float> transform(model.project(camera.get_transform().getM()));
+            Point<float,4> eye=model.inverse().apply(camera.get_position());
+            Vector<float,3> e{eye.x(),eye.y(),eye.z()};
+            if(edge_mode==FEATURE_EDGES&&o->has_creases()) {
+                draw_feature_edges(o,transform,e);
+                return;
+            }
+            // Only the faces of the subtrees of the hierarchy in the field of vision are transformed.
+            visible_faces.clear();
+            if(o->get_hierarchy().size()==0) {
+                for(uint32_t i=0;i<o->num_faces();++i)
+                    visible_faces.push_back(i);
+            } else {
+                o->get_hierarchy().traverse(Frustum::ALL_PLANES,[&](uint32_t, const AABB<float> &box, unsigned int &mask) {
+                    unsigned char last_plane=0;
+                    switch(camera.classify(model.apply(box),mask,last_plane)) {
+                        case Frustum::OUTSIDE: return DISJOINT;
+                        case Frustum::INSIDE: return CONTAINED;
+                        default: return OVERLAPPING;
+                    }
+                },[&](uint32_t i) {
+                    visible_faces.push_back(i);
+                });
+            }
+            // The faces turned away from the camera are dropped before any vertex is transformed, with one dot
+            // product against the position of the camera in object space.
+            bool all=(visible_faces.size()==o->num_faces());
+            size_t n=0;
+            for(size_t i=0;i<visible_faces.size();++i)
+                if(o->faces(visible_faces[i],e)) visible_faces[n++]=visible_faces[i];
+            if(n==0) return;
+            // Each vertex used by the faces is transformed once, into the post-transform cache the faces index
+            // into: all the vertices in one pass when the hierarchy left every face, otherwise the ones of the
+            // faces left, gathered first.
+            size_t nv=o->num_vertices();
+            if(all) {
+                vertex_buffer.resize(nv);
+                transform.apply_many(o->get_coords(0),o->get_coords(1),o->get_coords(2),vertex_buffer[0].data(),nv);
+            } else {
+                vertex_slots.assign(nv,NO_SLOT);
+                vertex_buffer.clear();
+                for(size_t i=0;i<n;++i)
+                    for(int k=0;k<3;++k)
+                        gather(o,o->index(visible_faces[i],k));
+                transform.apply_many(vertex_buffer[0].data(),vertex_buffer[0].data(),vertex_buffer.size());
+            }
+            // The edges of an object completely in the field of vision are not clipped.
+            Frustum::Visibility visibility=camera.classify(vertex_buffer.data(),vertex_buffer.size());
+            if(visibility==Frustum::OUTSIDE) return;
+            bool clip=(visibility==Frustum::INTERSECTING);
+            auto corner=[&](uint32_t v) -> const Point<float,4> & {
+                return vertex_buffer[all?v:vertex_slots[v]];
+            };
+            // With the table of the edges, an edge shared by two faces drawn is only drawn once.
+            if(o->get_edges().empty()) {
+                for(size_t i=0;i<n;++i) {
+                    uint32_t f=visible_faces[i];
+                    draw_wire_triangle(Triangle<float,4>(corner(o->index(f,0)),corner(o->index(f,1)),corner(o->index(f,2))),clip);
+                }
+                return;
+            }
+            o->visit_edges(visible_faces.data(),n,face_drawn,[&](uint32_t v0, uint32_t v1) {
+                draw_edge(corner(v0),corner(v1),clip);
+            });
+        }
+
+        // Adds the vertex v of the object given as argument to vertex_buffer (to be transformed), if it is not there
+        // yet, and stores its place in vertex_slots.
+        void gather(const Object3D *o, uint32_t v) const {
+            if(vertex_slots[v]==NO_SLOT) {
+                vertex_slots[v]=vertex_buffer.size();
+                vertex_buffer.push_back(o->vertex(v));
+            }
+        }
+
+        // Draws the feature edges of the object given as argument seen from eye (the camera in object space):
+        // its silhouette, and its boundary and crease edges facing the camera. transform is the one of draw_object.
+        void draw_feature_edges(const Object3D *o, const Transform<float> &transform, const Vector<float,3> &eye) const {
+            o->feature_edges(eye,feature_list);
+            if(feature_list.empty()) return;
+            const std::vector<Object3D::Edge> &edges=o->get_edges();
+            vertex_slots.assign(o->num_vertices(),NO_SLOT);
+            vertex_buffer.clear();
+            for(size_t i=0;i<feature_list.size();++i) {
+                gather(o,edges[feature_list[i]].v0);
+                gather(o,edges[feature_list[i]].v1);
+            }
+            transform.apply_many(vertex_buffer[0].data(),vertex_buffer[0].data(),vertex_buffer.size());
+            Frustum::Visibility visibility=camera.classify(vertex_buffer.data(),vertex_buffer.size());
+            if(visibility==Frustum::OUTSIDE) return;
+            bool clip=(visibility==Frustum::INTERSECTING);
+            for(size_t i=0;i<feature_list.size();++i) {
+                const Object3D::Edge &e=edges[feature_list[i]];
+                draw_edge(vertex_buffer[vertex_slots[e.v0]],vertex_buffer[vertex_slots[e.v1]],clip);
             }
         }
 
-        // Draws the face given as argument (the three edges of the triangle).
-        void draw_wire_triangle(const Triangle<float,4> &t1) const {
-            draw_edge(t1.get_p0(),t1.get_p1());
-            draw_edge(t1.get_p0(),t1.get_p2());
-            draw_edge(t1.get_p1(),t1.get_p2());
+        // Draws the face given as argument (the three edges of the triangle), clipped if clip is true.
+        void draw_wire_triangle(const Triangle<float,4> &t1, bool clip=true) const {
+            draw_edge(t1.get_p0(),t1.get_p1(),clip);
+            draw_edge(t1.get_p0(),t1.get_p2(),clip);
+            draw_edge(t1.get_p1(),t1.get_p2(),clip);
         }
 
-        // Draws the segment given as argument.
-        void draw_edge(const Point<float,4> &p1, const Point<float,4> &p2) const {
+        // Draws the segment given as argument, clipped if clip is true.
+        void draw_edge(const Point<float,4> &p1, const Point<float,4> &p2, bool clip=true) const {
             LineSegment<float,4> ls(p1,p2);
-            ls=camera.visible_part(ls);
+            if(clip) ls=camera.visible_part(ls);
             if(!ls.is_null()) {
                 Point<float,2> p1_2=perspective_projection(ls.get_begin());
                 Point<float,2> p2_2=perspective_projection(ls.get_end()); 
@@ -94,13 +279,14 @@ class Scene : public SceneInterface {
 
         // Projects the point given as argument on the screen (“near plane”).
         Vec2r perspective_projection(const Point<float,4> &p) const { 
-            float w=(p.at(3)==0)?1:p.at(3);
-            return Vec2r{p.at(0)/w,p.at(1)/w};
+            float w=(p.w()==0)?1:p.w();
+            return Vec2r{p.x()/w,p.y()/w};
         }
 
         // Adds an object in the scene.
         void addObject3D(Object3D *o) {
             objects.push_back(o);
+            rebuild=true;
         }
 
         ~Scene() {
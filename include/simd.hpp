@@ -0,0 +1,538 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// SSE/AVX kernels are only built with GCC or Clang on x86.
+// Defining LIBMATRIX_NO_SIMD forces the scalar kernels everywhere.
+#if !defined(LIBMATRIX_NO_SIMD) && (defined(__GNUC__)||defined(__clang__)) && \
+    (defined(__x86_64__)||defined(__i386__)) && defined(__SSE2__)
+#define LIBMATRIX_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace libmatrix {
+    namespace simd {
+
+        // Instruction sets a kernel can be run with, from the slowest to the fastest.
+        enum Level { SCALAR, SSE2, AVX };
+
+        // Returns the best level supported by the CPU running the program.
+        inline Level supported() {
+#ifdef LIBMATRIX_X86_SIMD
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("avx")) return AVX;
+            return SSE2;
+#else
+            return SCALAR;
+#endif
+        }
+
+        // Returns the level used by the kernels. It is detected once, and can be lowered
+        // with the LIBMATRIX_SIMD environment variable ("scalar", "sse2" or "avx").
+        inline Level &level() {
+            static Level l=[]() {
+                Level best=supported(),wanted=best;
+                const char *env=getenv("LIBMATRIX_SIMD");
+                if(env) {
+                    if(!strcmp(env,"scalar")) wanted=SCALAR;
+                    else if(!strcmp(env,"sse2")) wanted=SSE2;
+                    else if(!strcmp(env,"avx")) wanted=AVX;
+                }
+                return wanted<best?wanted:best;
+            }();
+            return l;
+        }
+
+        // Forces the level used by the kernels. Levels the CPU does not support are lowered.
+        inline void set_level(Level l) {
+            Level best=supported();
+            level()=(l<best)?l:best;
+        }
+
+        // Scalar kernels working on K-element arrays.
+        // The constexpr ones are also used in constant expressions, where the SIMD kernels cannot run.
+        template<typename T,int K>
+        struct Scalar {
+            // Returns the dot product of a and b.
+            static constexpr T dot(const T *a, const T *b) {
+                T res=0;
+                for(int i=0;i<K;++i)
+                    res+=a[i]*b[i];
+                return res;
+            }
+
+            // Writes the cross product of the first 3 coordinates of a and b in res.
+            static constexpr void cross(const T *a, const T *b, T *res) {
+                res[0]=(a[1]*b[2])-(a[2]*b[1]);
+                res[1]=(a[2]*b[0])-(a[0]*b[2]);
+                res[2]=(a[0]*b[1])-(a[1]*b[0]);
+            }
+
+            // Writes a normalised in res. Returns false, leaving res untouched, if a has a null norm.
+            static bool normalize(const T *a, T *res) {
+                T n=sqrt(dot(a,a));
+                if(n==0) return false;
+                T left=1/n;
+                for(int i=0;i<K;++i)
+                    res[i]=a[i]*left;
+                return true;
+            }
+
+            // Writes the product of the KxK matrix given by its rows and the vector v in res.
+            static constexpr void matvec(const T *const rows[K], const T *v, T *res) {
+                for(int i=0;i<K;++i)
+                    res[i]=dot(v,rows[i]);
+            }
+
+            // Multiplies the n K-element vectors stored one after the other in in by the KxK matrix
+            // given by its rows, and stores the results the same way in out (which can be in).
+            static void transform(const T *const rows[K], const T *in, T *out, size_t n) {
+                T tmp[K];
+                for(size_t p=0;p<n;++p,in+=K,out+=K) {
+                    for(int i=0;i<K;++i)
+                        tmp[i]=in[i];
+                    matvec(rows,tmp,out);
+                }
+            }
+
+            // Same as transform, for an affine matrix given by its K-1 first rows (the last one being 0 ... 0 1)
+            // and points whose last coordinate is 1: the last row is not computed.
+            static void transform_affine(const T *const rows[K-1], const T *in, T *out, size_t n) {
+                T tmp[K];
+                for(size_t p=0;p<n;++p,in+=K,out+=K) {
+                    for(int i=0;i<K;++i)
+                        tmp[i]=in[i];
+                    for(int i=0;i<K-1;++i) {
+                        T res=0;
+                        for(int k=0;k<K-1;++k)
+                            res+=tmp[k]*rows[i][k];
+                        out[i]=res+rows[i][K-1];
+                    }
+                    out[K-1]=1;
+                }
+            }
+
+            // Same as transform, for vectors stored as one array per coordinate. The last coordinate
+            // of the input vectors is not stored and equals 1.
+            static void transform_soa(const T *const rows[K], const T *const in[K-1], T *const out[K], size_t n) {
+                for(int i=0;i<K;++i) {
+                    const T *r=rows[i];
+                    T *o=out[i];
+                    for(size_t p=0;p<n;++p) {
+                        T tmp=0;
+                        for(int k=0;k<K-1;++k)
+                            tmp+=in[k][p]*r[k];
+                        o[p]=tmp+r[K-1];
+                    }
+                }
+            }
+
+            // Same as transform_soa, storing the results one after the other in out (K coordinates each).
+            static void transform_soa_to_aos(const T *const rows[K], const T *const in[K-1], T *out, size_t n) {
+                for(size_t p=0;p<n;++p,out+=K)
+                    for(int i=0;i<K;++i) {
+                        T tmp=0;
+                        for(int k=0;k<K-1;++k)
+                            tmp+=in[k][p]*rows[i][k];
+                        out[i]=tmp+rows[i][K-1];
+                    }
+            }
+
+            // Tests n spheres, given as one array per coordinate of their centers and one for their radii
+            // (in[0..2] and in[3]), against np planes of K coefficients. Sets the bit p%32 of visible[p/32]
+            // if the sphere p is not completely behind one of the planes, and clears it otherwise. If inside
+            // is not null, its bits are set the same way for the spheres completely in front of every plane.
+            // A sphere with a NaN coordinate is never visible.
+            static void cull_spheres(const T *const planes[], int np, const T *const in[K], size_t n, uint32_t *visible,
+                                     uint32_t *inside=nullptr) {
+                memset(visible,0,((n+31)/32)*sizeof(uint32_t));
+                if(inside) memset(inside,0,((n+31)/32)*sizeof(uint32_t));
+                for(size_t p=0;p<n;++p) {
+                    bool vis=true,in_all=true;
+                    for(int i=0;i<np;++i) {
+                        const T *pl=planes[i];
+                        T dist=((pl[0]*in[0][p]+pl[1]*in[1][p])+pl[2]*in[2][p])+pl[3];
+                        vis&=(dist>=0)|(dist+in[3][p]>=0);
+                        in_all&=(dist-in[3][p]>=0);
+                    }
+                    visible[p/32]|=(uint32_t)vis<<(p%32);
+                    if(inside) inside[p/32]|=(uint32_t)in_all<<(p%32);
+                }
+            }
+
+            // Same as cull_spheres, for axis-aligned boxes given by their centers (in[0..2]) and their
+            // half extents (in[3..5]).
+            static void cull_boxes(const T *const planes[], int np, const T *const in[6], size_t n, uint32_t *visible) {
+                memset(visible,0,((n+31)/32)*sizeof(uint32_t));
+                for(size_t p=0;p<n;++p) {
+                    bool inside=true;
+                    for(int i=0;i<np;++i) {
+                        const T *pl=planes[i];
+                        T dist=((pl[0]*in[0][p]+pl[1]*in[1][p])+pl[2]*in[2][p])+pl[3];
+                        T radius=(std::fabs(pl[0])*in[3][p]+std::fabs(pl[1])*in[4][p])+std::fabs(pl[2])*in[5][p];
+                        inside&=(dist+radius>=0);
+                    }
+                    visible[p/32]|=(uint32_t)inside<<(p%32);
+                }
+            }
+        };
+
+        // Scalar product of a NxM matrix and a MxW matrix, given by their rows.
+        template<typename T,int N,int M,int W>
+        struct ScalarMatMul {
+            static constexpr void run(const T *const a[N], const T *const b[M], T *const res[N]) {
+                T tmp=0;
+                for(int i=0;i<N;++i)
+                    for(int j=0;j<W;++j) {
+                        tmp=0;
+                        for(int k=0;k<M;++k)
+                            tmp+=a[i][k]*b[k][j];
+                        res[i][j]=tmp;
+                    }
+            }
+        };
+
+        // Kernels used by libmatrix. Specialised below for the sizes having a SIMD version.
+        template<typename T,int K>
+        struct Kernels : Scalar<T,K> {};
+
+        template<typename T,int N,int M,int W>
+        struct MatMul : ScalarMatMul<T,N,M,W> {};
+
+#ifdef LIBMATRIX_X86_SIMD
+        // The SSE kernels add the products in the same order as the scalar ones,
+        // so that every level gives bit-identical results.
+
+        // Returns the sum of the 4 lanes of p, added from the first to the last.
+        inline __m128 hsum_ordered(__m128 p) {
+            __m128 s=_mm_add_ss(p,_mm_shuffle_ps(p,p,_MM_SHUFFLE(1,1,1,1)));
+            s=_mm_add_ss(s,_mm_shuffle_ps(p,p,_MM_SHUFFLE(2,2,2,2)));
+            return _mm_add_ss(s,_mm_shuffle_ps(p,p,_MM_SHUFFLE(3,3,3,3)));
+        }
+
+        inline float dot_sse(const float *a, const float *b) {
+            return _mm_cvtss_f32(hsum_ordered(_mm_mul_ps(_mm_loadu_ps(a),_mm_loadu_ps(b))));
+        }
+
+        inline void cross_sse(const float *a, const float *b, float *res) {
+            __m128 va=_mm_loadu_ps(a),vb=_mm_loadu_ps(b);
+            __m128 a_yzx=_mm_shuffle_ps(va,va,_MM_SHUFFLE(3,0,2,1));
+            __m128 a_zxy=_mm_shuffle_ps(va,va,_MM_SHUFFLE(3,1,0,2));
+            __m128 b_yzx=_mm_shuffle_ps(vb,vb,_MM_SHUFFLE(3,0,2,1));
+            __m128 b_zxy=_mm_shuffle_ps(vb,vb,_MM_SHUFFLE(3,1,0,2));
+            float tmp[4];
+            _mm_storeu_ps(tmp,_mm_sub_ps(_mm_mul_ps(a_yzx,b_zxy),_mm_mul_ps(a_zxy,b_yzx)));
+            res[0]=tmp[0];
+            res[1]=tmp[1];
+            res[2]=tmp[2];
+        }
+
+        inline bool normalize_sse(const float *a, float *res) {
+            __m128 va=_mm_loadu_ps(a);
+            float n=sqrtf(_mm_cvtss_f32(hsum_ordered(_mm_mul_ps(va,va))));
+            if(n==0) return false;
+            _mm_storeu_ps(res,_mm_mul_ps(va,_mm_set1_ps(1/n)));
+            return true;
+        }
+
+        inline void matvec_sse(const float *const rows[4], const float *v, float *res) {
+            __m128 vv=_mm_loadu_ps(v);
+            __m128 p0=_mm_mul_ps(vv,_mm_loadu_ps(rows[0]));
+            __m128 p1=_mm_mul_ps(vv,_mm_loadu_ps(rows[1]));
+            __m128 p2=_mm_mul_ps(vv,_mm_loadu_ps(rows[2]));
+            __m128 p3=_mm_mul_ps(vv,_mm_loadu_ps(rows[3]));
+            // After the transpose, p<k> holds the k-th product of every row.
+            _MM_TRANSPOSE4_PS(p0,p1,p2,p3);
+            _mm_storeu_ps(res,_mm_add_ps(_mm_add_ps(_mm_add_ps(p0,p1),p2),p3));
+        }
+
+        inline void transform_sse(const float *const rows[4], const float *in, float *out, size_t n) {
+            __m128 r0=_mm_loadu_ps(rows[0]),r1=_mm_loadu_ps(rows[1]),r2=_mm_loadu_ps(rows[2]),r3=_mm_loadu_ps(rows[3]);
+            // Transposed matrix: c<k> holds the k-th column, so that a product is a sum of 4 broadcasts.
+            _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+            for(size_t p=0;p<n;++p,in+=4,out+=4) {
+                __m128 res=_mm_mul_ps(_mm_set1_ps(in[0]),r0);
+                res=_mm_add_ps(res,_mm_mul_ps(_mm_set1_ps(in[1]),r1));
+                res=_mm_add_ps(res,_mm_mul_ps(_mm_set1_ps(in[2]),r2));
+                res=_mm_add_ps(res,_mm_mul_ps(_mm_set1_ps(in[3]),r3));
+                _mm_storeu_ps(out,res);
+            }
+        }
+
+        inline void transform_affine_sse(const float *const rows[3], const float *in, float *out, size_t n) {
+            __m128 r0=_mm_loadu_ps(rows[0]),r1=_mm_loadu_ps(rows[1]),r2=_mm_loadu_ps(rows[2]),r3=_mm_set_ps(1,0,0,0);
+            _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+            // r3 holds the translation and a 1 for w, which is added rather than multiplied.
+            for(size_t p=0;p<n;++p,in+=4,out+=4) {
+                __m128 res=_mm_mul_ps(_mm_set1_ps(in[0]),r0);
+                res=_mm_add_ps(res,_mm_mul_ps(_mm_set1_ps(in[1]),r1));
+                res=_mm_add_ps(res,_mm_mul_ps(_mm_set1_ps(in[2]),r2));
+                _mm_storeu_ps(out,_mm_add_ps(res,r3));
+            }
+        }
+
+        inline void transform_soa_sse(const float *const rows[4], const float *const in[3], float *const out[4], size_t n) {
+            size_t p=0;
+            for(;p+4<=n;p+=4) {
+                __m128 x=_mm_loadu_ps(in[0]+p),y=_mm_loadu_ps(in[1]+p),z=_mm_loadu_ps(in[2]+p);
+                for(int i=0;i<4;++i) {
+                    const float *r=rows[i];
+                    __m128 res=_mm_mul_ps(x,_mm_set1_ps(r[0]));
+                    res=_mm_add_ps(res,_mm_mul_ps(y,_mm_set1_ps(r[1])));
+                    res=_mm_add_ps(res,_mm_mul_ps(z,_mm_set1_ps(r[2])));
+                    _mm_storeu_ps(out[i]+p,_mm_add_ps(res,_mm_set1_ps(r[3])));
+                }
+            }
+            for(;p<n;++p)
+                for(int i=0;i<4;++i)
+                    out[i][p]=((in[0][p]*rows[i][0]+in[1][p]*rows[i][1])+in[2][p]*rows[i][2])+rows[i][3];
+        }
+
+        inline void transform_soa_to_aos_sse(const float *const rows[4], const float *const in[3], float *out, size_t n) {
+            size_t p=0;
+            for(;p+4<=n;p+=4,out+=16) {
+                __m128 x=_mm_loadu_ps(in[0]+p),y=_mm_loadu_ps(in[1]+p),z=_mm_loadu_ps(in[2]+p);
+                __m128 res[4];
+                for(int i=0;i<4;++i) {
+                    const float *r=rows[i];
+                    res[i]=_mm_mul_ps(x,_mm_set1_ps(r[0]));
+                    res[i]=_mm_add_ps(res[i],_mm_mul_ps(y,_mm_set1_ps(r[1])));
+                    res[i]=_mm_add_ps(res[i],_mm_mul_ps(z,_mm_set1_ps(r[2])));
+                    res[i]=_mm_add_ps(res[i],_mm_set1_ps(r[3]));
+                }
+                // After the transpose, res[k] holds the coordinates of the k-th point.
+                _MM_TRANSPOSE4_PS(res[0],res[1],res[2],res[3]);
+                for(int k=0;k<4;++k)
+                    _mm_storeu_ps(out+4*k,res[k]);
+            }
+            for(;p<n;++p,out+=4)
+                for(int i=0;i<4;++i)
+                    out[i]=((in[0][p]*rows[i][0]+in[1][p]*rows[i][1])+in[2][p]*rows[i][2])+rows[i][3];
+        }
+
+        inline void matmul_sse(const float *const a[4], const float *const b[4], float *const res[4]) {
+            __m128 b0=_mm_loadu_ps(b[0]),b1=_mm_loadu_ps(b[1]),b2=_mm_loadu_ps(b[2]),b3=_mm_loadu_ps(b[3]);
+            for(int i=0;i<4;++i) {
+                __m128 r=_mm_mul_ps(_mm_set1_ps(a[i][0]),b0);
+                r=_mm_add_ps(r,_mm_mul_ps(_mm_set1_ps(a[i][1]),b1));
+                r=_mm_add_ps(r,_mm_mul_ps(_mm_set1_ps(a[i][2]),b2));
+                r=_mm_add_ps(r,_mm_mul_ps(_mm_set1_ps(a[i][3]),b3));
+                _mm_storeu_ps(res[i],r);
+            }
+        }
+
+        // Tests 4 spheres per iteration, one per lane. Groups of 4 never straddle two words of visible.
+        inline void cull_spheres_sse(const float *const planes[], int np, const float *const in[4], size_t n, uint32_t *visible,
+                                     uint32_t *inside) {
+            memset(visible,0,((n+31)/32)*sizeof(uint32_t));
+            if(inside) memset(inside,0,((n+31)/32)*sizeof(uint32_t));
+            __m128 zero=_mm_setzero_ps();
+            size_t p=0;
+            for(;p+4<=n;p+=4) {
+                __m128 x=_mm_loadu_ps(in[0]+p),y=_mm_loadu_ps(in[1]+p),z=_mm_loadu_ps(in[2]+p),r=_mm_loadu_ps(in[3]+p);
+                __m128 vis=_mm_castsi128_ps(_mm_set1_epi32(-1)),in_all=vis;
+                for(int i=0;i<np;++i) {
+                    const float *pl=planes[i];
+                    __m128 dist=_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl[0]),x),
+                                _mm_mul_ps(_mm_set1_ps(pl[1]),y)),_mm_mul_ps(_mm_set1_ps(pl[2]),z)),_mm_set1_ps(pl[3]));
+                    vis=_mm_and_ps(vis,_mm_or_ps(_mm_cmpge_ps(dist,zero),_mm_cmpge_ps(_mm_add_ps(dist,r),zero)));
+                    in_all=_mm_and_ps(in_all,_mm_cmpge_ps(_mm_sub_ps(dist,r),zero));
+                }
+                visible[p/32]|=(uint32_t)_mm_movemask_ps(vis)<<(p%32);
+                if(inside) inside[p/32]|=(uint32_t)_mm_movemask_ps(in_all)<<(p%32);
+            }
+            if(p<n) {
+                const float *tail[4]={in[0]+p,in[1]+p,in[2]+p,in[3]+p};
+                uint32_t bits,in_bits;
+                Scalar<float,4>::cull_spheres(planes,np,tail,n-p,&bits,&in_bits);
+                visible[p/32]|=bits<<(p%32);
+                if(inside) inside[p/32]|=in_bits<<(p%32);
+            }
+        }
+
+        inline void cull_boxes_sse(const float *const planes[], int np, const float *const in[6], size_t n, uint32_t *visible) {
+            memset(visible,0,((n+31)/32)*sizeof(uint32_t));
+            __m128 zero=_mm_setzero_ps();
+            size_t p=0;
+            for(;p+4<=n;p+=4) {
+                __m128 x=_mm_loadu_ps(in[0]+p),y=_mm_loadu_ps(in[1]+p),z=_mm_loadu_ps(in[2]+p);
+                __m128 ex=_mm_loadu_ps(in[3]+p),ey=_mm_loadu_ps(in[4]+p),ez=_mm_loadu_ps(in[5]+p);
+                __m128 inside=_mm_castsi128_ps(_mm_set1_epi32(-1));
+                for(int i=0;i<np;++i) {
+                    const float *pl=planes[i];
+                    __m128 dist=_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl[0]),x),
+                                _mm_mul_ps(_mm_set1_ps(pl[1]),y)),_mm_mul_ps(_mm_set1_ps(pl[2]),z)),_mm_set1_ps(pl[3]));
+                    __m128 radius=_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(pl[0])),ex),
+                                  _mm_mul_ps(_mm_set1_ps(std::fabs(pl[1])),ey)),_mm_mul_ps(_mm_set1_ps(std::fabs(pl[2])),ez));
+                    inside=_mm_and_ps(inside,_mm_cmpge_ps(_mm_add_ps(dist,radius),zero));
+                }
+                visible[p/32]|=(uint32_t)_mm_movemask_ps(inside)<<(p%32);
+            }
+            if(p<n) {
+                const float *tail[6]={in[0]+p,in[1]+p,in[2]+p,in[3]+p,in[4]+p,in[5]+p};
+                uint32_t bits;
+                Scalar<float,4>::cull_boxes(planes,np,tail,n-p,&bits);
+                visible[p/32]|=bits<<(p%32);
+            }
+        }
+
+        // Returns a 256-bit register holding s1 in its low half and s2 in its high half.
+        __attribute__((target("avx")))
+        inline __m256 set_halves(float s1, float s2) {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(s1)),_mm_set1_ps(s2),1);
+        }
+
+        // Computes two rows of the result per iteration.
+        __attribute__((target("avx")))
+        inline void matmul_avx(const float *const a[4], const float *const b[4], float *const res[4]) {
+            __m256 b0=_mm256_broadcast_ps((const __m128 *)b[0]),b1=_mm256_broadcast_ps((const __m128 *)b[1]);
+            __m256 b2=_mm256_broadcast_ps((const __m128 *)b[2]),b3=_mm256_broadcast_ps((const __m128 *)b[3]);
+            for(int i=0;i<4;i+=2) {
+                __m256 r=_mm256_mul_ps(set_halves(a[i][0],a[i+1][0]),b0);
+                r=_mm256_add_ps(r,_mm256_mul_ps(set_halves(a[i][1],a[i+1][1]),b1));
+                r=_mm256_add_ps(r,_mm256_mul_ps(set_halves(a[i][2],a[i+1][2]),b2));
+                r=_mm256_add_ps(r,_mm256_mul_ps(set_halves(a[i][3],a[i+1][3]),b3));
+                _mm_storeu_ps(res[i],_mm256_castps256_ps128(r));
+                _mm_storeu_ps(res[i+1],_mm256_extractf128_ps(r,1));
+            }
+        }
+
+        // Same as cull_spheres_sse, 8 spheres per iteration.
+        __attribute__((target("avx")))
+        inline void cull_spheres_avx(const float *const planes[], int np, const float *const in[4], size_t n, uint32_t *visible,
+                                     uint32_t *inside) {
+            memset(visible,0,((n+31)/32)*sizeof(uint32_t));
+            if(inside) memset(inside,0,((n+31)/32)*sizeof(uint32_t));
+            __m256 zero=_mm256_setzero_ps();
+            size_t p=0;
+            for(;p+8<=n;p+=8) {
+                __m256 x=_mm256_loadu_ps(in[0]+p),y=_mm256_loadu_ps(in[1]+p),z=_mm256_loadu_ps(in[2]+p),r=_mm256_loadu_ps(in[3]+p);
+                __m256 vis=_mm256_castsi256_ps(_mm256_set1_epi32(-1)),in_all=vis;
+                for(int i=0;i<np;++i) {
+                    const float *pl=planes[i];
+                    __m256 dist=_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(pl[0]),x),
+                                _mm256_mul_ps(_mm256_set1_ps(pl[1]),y)),_mm256_mul_ps(_mm256_set1_ps(pl[2]),z)),_mm256_set1_ps(pl[3]));
+                    vis=_mm256_and_ps(vis,_mm256_or_ps(_mm256_cmp_ps(dist,zero,_CMP_GE_OQ),
+                                                       _mm256_cmp_ps(_mm256_add_ps(dist,r),zero,_CMP_GE_OQ)));
+                    in_all=_mm256_and_ps(in_all,_mm256_cmp_ps(_mm256_sub_ps(dist,r),zero,_CMP_GE_OQ));
+                }
+                visible[p/32]|=(uint32_t)_mm256_movemask_ps(vis)<<(p%32);
+                if(inside) inside[p/32]|=(uint32_t)_mm256_movemask_ps(in_all)<<(p%32);
+            }
+            if(p<n) {
+                const float *tail[4]={in[0]+p,in[1]+p,in[2]+p,in[3]+p};
+                uint32_t bits,in_bits;
+                Scalar<float,4>::cull_spheres(planes,np,tail,n-p,&bits,&in_bits);
+                visible[p/32]|=bits<<(p%32);
+                if(inside) inside[p/32]|=in_bits<<(p%32);
+            }
+        }
+
+        // Same as cull_boxes_sse, 8 boxes per iteration.
+        __attribute__((target("avx")))
+        inline void cull_boxes_avx(const float *const planes[], int np, const float *const in[6], size_t n, uint32_t *visible) {
+            memset(visible,0,((n+31)/32)*sizeof(uint32_t));
+            __m256 zero=_mm256_setzero_ps();
+            size_t p=0;
+            for(;p+8<=n;p+=8) {
+                __m256 x=_mm256_loadu_ps(in[0]+p),y=_mm256_loadu_ps(in[1]+p),z=_mm256_loadu_ps(in[2]+p);
+                __m256 ex=_mm256_loadu_ps(in[3]+p),ey=_mm256_loadu_ps(in[4]+p),ez=_mm256_loadu_ps(in[5]+p);
+                __m256 inside=_mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for(int i=0;i<np;++i) {
+                    const float *pl=planes[i];
+                    __m256 dist=_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(pl[0]),x),
+                                _mm256_mul_ps(_mm256_set1_ps(pl[1]),y)),_mm256_mul_ps(_mm256_set1_ps(pl[2]),z)),_mm256_set1_ps(pl[3]));
+                    __m256 radius=_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::fabs(pl[0])),ex),
+                                  _mm256_mul_ps(_mm256_set1_ps(std::fabs(pl[1])),ey)),_mm256_mul_ps(_mm256_set1_ps(std::fabs(pl[2])),ez));
+                    inside=_mm256_and_ps(inside,_mm256_cmp_ps(_mm256_add_ps(dist,radius),zero,_CMP_GE_OQ));
+                }
+                visible[p/32]|=(uint32_t)_mm256_movemask_ps(inside)<<(p%32);
+            }
+            if(p<n) {
+                const float *tail[6]={in[0]+p,in[1]+p,in[2]+p,in[3]+p,in[4]+p,in[5]+p};
+                uint32_t bits;
+                Scalar<float,4>::cull_boxes(planes,np,tail,n-p,&bits);
+                visible[p/32]|=bits<<(p%32);
+            }
+        }
+
+        template<>
+        struct Kernels<float,4> {
+            static float dot(const float *a, const float *b) {
+                if(level()==SCALAR) return Scalar<float,4>::dot(a,b);
+                return dot_sse(a,b);
+            }
+
+            static void cross(const float *a, const float *b, float *res) {
+                if(level()==SCALAR) Scalar<float,4>::cross(a,b,res);
+                else cross_sse(a,b,res);
+            }
+
+            static bool normalize(const float *a, float *res) {
+                if(level()==SCALAR) return Scalar<float,4>::normalize(a,res);
+                return normalize_sse(a,res);
+            }
+
+            static void matvec(const float *const rows[4], const float *v, float *res) {
+                if(level()==SCALAR) Scalar<float,4>::matvec(rows,v,res);
+                else matvec_sse(rows,v,res);
+            }
+
+            static void transform(const float *const rows[4], const float *in, float *out, size_t n) {
+                if(level()==SCALAR) Scalar<float,4>::transform(rows,in,out,n);
+                else transform_sse(rows,in,out,n);
+            }
+
+            static void transform_affine(const float *const rows[3], const float *in, float *out, size_t n) {
+                if(level()==SCALAR) Scalar<float,4>::transform_affine(rows,in,out,n);
+                else transform_affine_sse(rows,in,out,n);
+            }
+
+            static void transform_soa(const float *const rows[4], const float *const in[3], float *const out[4], size_t n) {
+                if(level()==SCALAR) Scalar<float,4>::transform_soa(rows,in,out,n);
+                else transform_soa_sse(rows,in,out,n);
+            }
+
+            static void transform_soa_to_aos(const float *const rows[4], const float *const in[3], float *out, size_t n) {
+                if(level()==SCALAR) Scalar<float,4>::transform_soa_to_aos(rows,in,out,n);
+                else transform_soa_to_aos_sse(rows,in,out,n);
+            }
+
+            static void cull_spheres(const float *const planes[], int np, const float *const in[4], size_t n, uint32_t *visible,
+                                     uint32_t *inside=nullptr) {
+                switch(level()) {
+                    case AVX: cull_spheres_avx(planes,np,in,n,visible,inside); break;
+                    case SSE2: cull_spheres_sse(planes,np,in,n,visible,inside); break;
+                    default: Scalar<float,4>::cull_spheres(planes,np,in,n,visible,inside);
+                }
+            }
+
+            static void cull_boxes(const float *const planes[], int np, const float *const in[6], size_t n, uint32_t *visible) {
+                switch(level()) {
+                    case AVX: cull_boxes_avx(planes,np,in,n,visible); break;
+                    case SSE2: cull_boxes_sse(planes,np,in,n,visible); break;
+                    default: Scalar<float,4>::cull_boxes(planes,np,in,n,visible);
+                }
+            }
+        };
+
+        template<>
+        struct MatMul<float,4,4,4> {
+            static void run(const float *const a[4], const float *const b[4], float *const res[4]) {
+                switch(level()) {
+                    case AVX: matmul_avx(a,b,res); break;
+                    case SSE2: matmul_sse(a,b,res); break;
+                    default: ScalarMatMul<float,4,4,4>::run(a,b,res);
+                }
+            }
+        };
+#endif
+    }
+}
+
+#endif
@@ -37,8 +37,6 @@ namespace libgeometry {
 
             template<typename U,int M>
             friend std::ostream &operator <<(std::ostream &out, Sphere<U,M> s);
-
-            ~Sphere(){}
     };
 
     template<typename T,int N>
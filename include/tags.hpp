@@ -0,0 +1,16 @@
+#ifndef TAGS_HPP
+#define TAGS_HPP
+
+namespace libmatrix {
+
+    // Constructor tags. Vector() and Matrix() fill their elements with the null value, which is only
+    // needed when a result may be null. These tags build them with uninitialised elements, which must
+    // be written before being read, or with zeros.
+    struct uninit_t { explicit uninit_t()=default; };
+    struct zero_t { explicit zero_t()=default; };
+
+    constexpr uninit_t uninit{};
+    constexpr zero_t zero{};
+}
+
+#endif
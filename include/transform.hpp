@@ -8,24 +8,40 @@
 #include "point.hpp"
 #include "direction.hpp"
 #include "sphere.hpp"
+#include "valid.hpp"
 
 using namespace std;
 
 namespace libgeometry {
     
+    // Kinds of transforms, from the most specific to the most general.
+    // RIGID: rotation and translation. AFFINE: last row of the matrix is 0 0 0 1. PROJECTIVE: anything else.
+    enum TransformKind { RIGID, AFFINE, PROJECTIVE };
+
+    template<typename T>
+    class Affine3;
+
     template<typename T>
     class Transform {
         private:
             Matrix<T,4,4> m;
             Quaternion<T> q;
+            TransformKind kind;
+
+            constexpr Transform(const Matrix<T,4,4> &_m, TransformKind k) : m(_m), kind(k) {}
 
         public:
-            Transform() {}
+            constexpr Transform() : kind(PROJECTIVE) {}
+
+            constexpr Transform(const Matrix<T,4,4> &_m) : m(_m), kind(PROJECTIVE) {
+                kind=(m.at(3,0)==0&&m.at(3,1)==0&&m.at(3,2)==0&&m.at(3,3)==1)?AFFINE:PROJECTIVE;
+            }
 
-            Transform(const Matrix<T,4,4> &_m) : m(_m) {}
+            // Converts an affine transform (see affine.hpp) to its 4x4 matrix.
+            constexpr explicit Transform(const Affine3<T> &a) : m(a.to_matrix()), kind(a.getKind()) {}
 
-            Transform(Quaternion<T> _q) {
-                q=_q;
+            // Only a unit quaternion gives a rotation matrix.
+            constexpr Transform(Quaternion<T> _q) : m(uninit), q(_q), kind((constmath::abs(_q.dot(_q)-1)<1e-5)?RIGID:AFFINE) {
                 m[0][0]=1-2*(_q[1]*_q[1])-2*(_q[2]*_q[2]);
                 m[0][1]=2*(_q[0]*_q[1])-2*(_q[3]*_q[2]);
                 m[0][2]=2*(_q[0]*_q[2])+2*(_q[3]*_q[1]);
@@ -44,13 +60,9 @@ namespace libgeometry {
                 m[3][3]=1;
             }
 
-            Transform(float angle,const Direction<T,4> &axis) {
-                q=Quaternion<T>(angle,axis);
-                *this=Transform<T>(q);
-            }
+            constexpr Transform(float angle,const Direction<T,4> &axis) : Transform(Quaternion<T>(angle,axis)) {}
 
-            Transform(Vector<T,3> v, bool scale=false) {
-                m=m.identity();
+            constexpr Transform(Vector<T,3> v, bool scale=false) : m(Matrix<T,4,4>::identity()), kind(scale?AFFINE:RIGID) {
                 if(scale) {
                     for(int i=0;i<3;++i)
                         m[i][i]=v[i];
@@ -62,10 +74,23 @@ namespace libgeometry {
             }
 
             // Returns the concatenation of two transforms.
-            Transform<T> concat(const Transform<T> &tr) const {
-                return Transform<float>(tr.getM()*m);
+            constexpr Transform<T> concat(const Transform<T> &tr) const {
+                return Transform<T>(tr.getM()*m,(kind>tr.kind)?kind:tr.kind);
+            }
+
+            // Returns the inverse transform, computed with the cheapest method allowed by its kind.
+            // Returns a transform with a null matrix if the transform is not invertible.
+            constexpr Transform<T> inverse() const {
+                switch(kind) {
+                    case RIGID: return Transform<T>(m.inverse_rigid(),RIGID);
+                    case AFFINE: return Transform<T>(m.inverse_affine(),AFFINE);
+                    default: return Transform<T>(m.inverse_cofactor(),PROJECTIVE);
+                }
             }
 
+            // Returns the kind of the transform.
+            constexpr TransformKind getKind() const { return kind; }
+
             // Returns the quaternion corresponding to a rotation stored in the transform.
             inline Quaternion<T> to_quat() {
                 if(q.is_null()) {
@@ -102,12 +127,48 @@ namespace libgeometry {
             }
 
             // Returns a new point corresponding to the transform applied to the point given as argument.
-            Point<T,4> apply(Point<T,4> p) const {
+            constexpr Point<T,4> apply(Point<T,4> p) const {
                 return Point<T,4>(m*p);
             }
 
+            // Same as apply, for a point known to be valid: no null check is made.
+            Valid<Point<T,4>> apply(const Valid<Point<T,4>> &p) const {
+                LIBMATRIX_ASSERT_VALID(m);
+                Point<T,4> res(uninit);
+                const T *rows[4]={m[0].data(),m[1].data(),m[2].data(),m[3].data()};
+                simd::Kernels<T,4>::matvec(rows,p.data(),res.data());
+                return Valid<Point<T,4>>(res);
+            }
+
+            // Applies the transform to n points stored one after the other in in (4 coordinates each, as in
+            // a contiguous array of Point<T,4>), and stores the results the same way in out, which can be in.
+            // The points must be valid: unlike apply, no null check is made. Their w is taken as 1 if the
+            // transform is not projective, whose last row is then skipped.
+            void apply_many(const T *in, T *out, size_t n) const {
+                const T *rows[4]={m[0].data(),m[1].data(),m[2].data(),m[3].data()};
+                if(kind==PROJECTIVE) simd::Kernels<T,4>::transform(rows,in,out,n);
+                else simd::Kernels<T,4>::transform_affine(rows,in,out,n);
+            }
+
+            // Same as apply_many, for n points stored as one array per coordinate (w is implicitly 1).
+            // The results are stored in ox, oy, oz and ow.
+            void apply_many(const T *x, const T *y, const T *z, T *ox, T *oy, T *oz, T *ow, size_t n) const {
+                const T *rows[4]={m[0].data(),m[1].data(),m[2].data(),m[3].data()};
+                const T *in[3]={x,y,z};
+                T *out[4]={ox,oy,oz,ow};
+                simd::Kernels<T,4>::transform_soa(rows,in,out,n);
+            }
+
+            // Same as apply_many, for n points stored as one array per coordinate (w is implicitly 1).
+            // The results are stored one after the other in out (4 coordinates each).
+            void apply_many(const T *x, const T *y, const T *z, T *out, size_t n) const {
+                const T *rows[4]={m[0].data(),m[1].data(),m[2].data(),m[3].data()};
+                const T *in[3]={x,y,z};
+                simd::Kernels<T,4>::transform_soa_to_aos(rows,in,out,n);
+            }
+
             // Returns a new direction corresponding to the transform applied to the direction given as argument.
-            Direction<T,4> apply(Direction<T,4> &d) const {
+            constexpr Direction<T,4> apply(Direction<T,4> &d) const {
                 return Direction<T,4>(m*d);
             }
 
@@ -136,9 +197,7 @@ namespace libgeometry {
             friend std::ostream &operator <<(std::ostream &out, Transform<U> t);
 
             // Returns the matrix corresponding to the transform.
-            inline Matrix<T,4,4> getM() const { return m; }
-
-            ~Transform() {}
+            constexpr Matrix<T,4,4> getM() const { return m; }
     };
 
     template<typename T>
@@ -58,8 +58,6 @@ namespace libgeometry {
 
             template<typename U,int M>
             friend std::ostream &operator <<(std::ostream &out, Triangle<U,M> t);
-
-            ~Triangle(){}
     };
 
     template<typename T,int N>
@@ -0,0 +1,95 @@
+#ifndef TRS_HPP
+#define TRS_HPP
+
+#include <iostream>
+#include "vector.hpp"
+#include "quaternion.hpp"
+#include "affine.hpp"
+#include "transform.hpp"
+
+namespace libgeometry {
+
+    // Transform kept as a translation, a rotation (unit quaternion) and a uniform scale, applied
+    // in the order scale, rotation, translation. Transforms are composed in this form, and the matrix
+    // is only computed when asked for, then cached until one of the components changes.
+    template<typename T>
+    class TRS {
+        private:
+            Vector<T,3> translation;
+            Quaternion<T> rotation;
+            T scale;
+            mutable Affine3<T> matrix;
+            mutable bool dirty;
+
+            // Returns the vector given as argument rotated by the rotation of the transform.
+            Vector<T,3> rotate(const Vector<T,3> &v) const {
+                Vector<T,3> u=rotation.im();
+                Vector<T,3> t=u.cross(v)*2;
+                return v+t*rotation.re()+u.cross(t);
+            }
+
+            // Returns the quaternion given as argument normalised, so that it is a rotation.
+            static Quaternion<T> unit(const Quaternion<T> &r) {
+                Vector<T,4> u=r.to_unit();
+                return Quaternion<T>{u[0],u[1],u[2],u[3]};
+            }
+
+        public:
+            TRS() : translation(zero), rotation{0,0,0,1}, scale(1), dirty(true) {}
+
+            // Builds the transform of the given components, the rotation being normalised as in set_rotation.
+            TRS(const Vector<T,3> &t, const Quaternion<T> &r=Quaternion<T>{0,0,0,1}, T s=1)
+                : translation(t), rotation(unit(r)), scale(s), dirty(true) {}
+
+            inline const Vector<T,3> &get_translation() const { return translation; }
+            inline const Quaternion<T> &get_rotation() const { return rotation; }
+            inline T get_scale() const { return scale; }
+
+            inline void set_translation(const Vector<T,3> &t) { translation=t; dirty=true; }
+            inline void set_scale(T s) { scale=s; dirty=true; }
+
+            // Sets the rotation, normalised so that the transform stays a rotation.
+            void set_rotation(const Quaternion<T> &r) {
+                rotation=unit(r);
+                dirty=true;
+            }
+
+            // Returns true if the matrix will be recomputed on the next call to affine.
+            inline bool is_dirty() const { return dirty; }
+
+            // Returns the concatenation of two transforms (this one, then the one given as argument),
+            // without computing any matrix.
+            TRS<T> concat(const TRS<T> &tr) const {
+                Quaternion<T> r=tr.rotation;
+                Vector<T,3> t=tr.translation+tr.rotate(translation)*tr.scale;
+                return TRS<T>(t,r*rotation,scale*tr.scale);
+            }
+
+            // Returns the matrix of the transform, computed only if a component changed since the last call.
+            const Affine3<T> &affine() const {
+                if(dirty) {
+                    Matrix<T,3,4> m=Affine3<T>(rotation).getM();
+                    for(int i=0;i<3;++i) {
+                        m[i]*=scale;
+                        m[i][3]=translation[i];
+                    }
+                    matrix=Affine3<T>(m,(scale==1)?RIGID:AFFINE);
+                    dirty=false;
+                }
+                return matrix;
+            }
+
+            // Returns the matrix of the transform as a Transform.
+            Transform<T> transform() const {
+                return Transform<T>(affine());
+            }
+    };
+
+    template<typename T>
+    std::ostream &operator <<(std::ostream &out, const TRS<T> &t) {
+        out << '(' << t.get_translation() << ',' << t.get_rotation() << ',' << t.get_scale() << ')';
+        return out;
+    }
+}
+
+#endif
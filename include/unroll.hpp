@@ -0,0 +1,33 @@
+#ifndef UNROLL_HPP
+#define UNROLL_HPP
+
+#include <utility>
+
+namespace libmatrix {
+
+    // Calls f(0), f(1) ... f(N-1), as straight-line code rather than a loop.
+    template<int N,typename F>
+    constexpr void unroll(F &&f) {
+        [&]<int... I>(std::integer_sequence<int,I...>) {
+            (f(I),...);
+        }(std::make_integer_sequence<int,N>());
+    }
+
+    // Returns true if f(i) is true for every i in [0,N), stopping at the first false.
+    template<int N,typename F>
+    constexpr bool unroll_all(F &&f) {
+        return [&]<int... I>(std::integer_sequence<int,I...>) {
+            return (f(I)&&...);
+        }(std::make_integer_sequence<int,N>());
+    }
+
+    // Returns true if f(i) is true for at least one i in [0,N), stopping at the first true.
+    template<int N,typename F>
+    constexpr bool unroll_any(F &&f) {
+        return [&]<int... I>(std::integer_sequence<int,I...>) {
+            return (f(I)||...);
+        }(std::make_integer_sequence<int,N>());
+    }
+}
+
+#endif
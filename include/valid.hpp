@@ -0,0 +1,76 @@
+#ifndef VALID_HPP
+#define VALID_HPP
+
+#include <cassert>
+#include <math.h>
+#include "vector.hpp"
+#include "simd.hpp"
+
+// Checks, in debug builds only, that a vector or a matrix known to be valid really is.
+#define LIBMATRIX_ASSERT_VALID(v) assert(!(v).is_null())
+
+namespace libmatrix {
+
+    // Vector (or Point, Direction, Plane...) known to contain valid values.
+    // The vector types check for null values in every operation, so that invalid user input propagates
+    // as a null result. Valid is checked once, when built, and its operations skip these checks: it is
+    // meant for the inner loops, once the input has been checked at their boundary.
+    // The operands given to its operations must be valid too, which is only asserted in debug builds.
+    template<typename V>
+    class Valid : public V {
+        private:
+            typedef typename V::value_type T;
+            static constexpr int N=V::dimension;
+
+        public:
+            constexpr explicit Valid(const V &v) : V(v) {
+                LIBMATRIX_ASSERT_VALID(*this);
+            }
+
+            template<typename E>
+            constexpr explicit Valid(const VecExpr<E,T,N> &e) : V(e) {
+                LIBMATRIX_ASSERT_VALID(*this);
+            }
+
+            // Dot product with another vector.
+            T dot(const Vector<T,N> &v) const {
+                LIBMATRIX_ASSERT_VALID(v);
+                return simd::Kernels<T,N>::dot(this->data(),v.data());
+            }
+
+            // Cross product with another vector, using only the first 3 coordinates.
+            template<int M>
+            Valid<Vector<T,3>> cross(const Vector<T,M> &v) const {
+                static_assert(N>=3&&M>=3,"Valid::cross : vectors of at least 3 elements only");
+                LIBMATRIX_ASSERT_VALID(v);
+                Vector<T,3> res(uninit);
+                simd::Kernels<T,(N<M)?N:M>::cross(this->data(),v.data(),res.data());
+                return Valid<Vector<T,3>>(res);
+            }
+
+            // Returns the norm of the vector.
+            T norm() const {
+                return sqrt(simd::Kernels<T,N>::dot(this->data(),this->data()));
+            }
+
+            // Returns a copy of the vector normalised (the vector itself if its norm is null).
+            Valid<V> to_unit() const {
+                Valid<V> res=*this;
+                simd::Kernels<T,N>::normalize(this->data(),res.data());
+                return res;
+            }
+
+            // Returns the signed distance between the point and the (normalised) plane given as argument.
+            T distance(const Vector<T,N> &p) const {
+                LIBMATRIX_ASSERT_VALID(p);
+                return (*this)[0]*p[0]+(*this)[1]*p[1]+(*this)[2]*p[2]+p[3];
+            }
+
+            // Returns true if the point is behind the plane given as argument, and false otherwise.
+            bool behind(const Vector<T,N> &p) const {
+                return distance(p)<0;
+            }
+    };
+}
+
+#endif
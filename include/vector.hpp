@@ -2,8 +2,14 @@
 #define VECTOR_HPP
 
 #include "matrix.hpp"
+#include "simd.hpp"
+#include "expression.hpp"
+#include "tags.hpp"
+#include "unroll.hpp"
 #include <iostream>
 #include <stdexcept>
+#include <limits>
+#include <type_traits>
 #include <math.h>
 #include<bits/stdc++.h> 
 
@@ -11,21 +17,40 @@ namespace libmatrix {
     
     template<typename T,int N,int M>
     class Matrix;
-    
+
+    // Alignment of the vectors of N elements of type T. 2 and 4-element vectors are aligned on their size,
+    // so that they can be loaded at once in a SIMD register. 3-element vectors are not padded.
+    template<typename T,int N>
+    constexpr size_t vector_alignment=(N==2||N==4)?N*sizeof(T):alignof(T);
+
+    // The element-wise operations are unrolled (see unroll.hpp): for the small sizes used here, they
+    // compile to straight-line code.
     template <typename T,int N>
-    class Vector {
+    class alignas(vector_alignment<T,N>) Vector {
         protected:
             T array[N];
 
+            typedef VecRef<T,N> Ref;
+
         public:
-            Vector() {
-                if (std::is_same<T, int>::value)
-                    for(int i=0;i<N;++i) array[i]=INT_MAX;
-                else
-                    for(int i=0;i<N;++i) array[i]=NAN;
+            typedef T value_type;
+            static constexpr int dimension=N;
+
+            // Value of the elements of a null vector.
+            static constexpr T null_value() {
+                if constexpr (std::is_same<T, int>::value) return INT_MAX;
+                else return std::numeric_limits<T>::quiet_NaN();
             }
 
-            Vector(std::initializer_list<T> l) {
+            constexpr Vector() {
+                unroll<N>([&](int i) { array[i]=null_value(); });
+            }
+
+            constexpr explicit Vector(uninit_t) {}
+
+            constexpr explicit Vector(zero_t) : array{} {}
+
+            constexpr Vector(std::initializer_list<T> l) : array{} {
                 if(l.size()==1)
                     for(int i=0;i<N;++i) array[i]=l.begin()[0];
                 else
@@ -33,10 +58,22 @@ namespace libmatrix {
                         array[i]=l.begin()[i];
             }
 
+            // Evaluates an arithmetic expression into the new vector, in a single loop.
+            template<typename E>
+            constexpr Vector(const VecExpr<E,T,N> &e) {
+                unroll<N>([&](int i) { array[i]=e.self()[i]; });
+            }
+
+            template<typename E>
+            constexpr Vector<T,N> &operator=(const VecExpr<E,T,N> &e) {
+                unroll<N>([&](int i) { array[i]=e.self()[i]; });
+                return *this;
+            }
+
             // Addresses the i-th element of the vector.
             // Raises an exception if i is out of range.
-            virtual T at(int i) const {
-                T t;
+            constexpr T at(int i) const {
+                T t=0;
                 if(i<N) t = array[i];
                 else throw std::out_of_range("Vector::at : i out of range");
                 return t;
@@ -46,23 +83,20 @@ namespace libmatrix {
             // Uses only the first 3 coordinates.
             // Raises an exception if the vector has less than 3 elements.
             template<int M>
-            Vector<T,3> cross(const Vector<T,M> &v) const {
-                Vector<T,3> res;
-                if(is_null()||v.is_null()) return res;
+            constexpr Vector<T,3> cross(const Vector<T,M> &v) const {
+                if(is_null()||v.is_null()) return Vector<T,3>();
                 if(N<3||M<3) throw std::out_of_range("Vector::cross : out of range");
-                res[0]=(at(1)*v.at(2))-(at(2)*v.at(1));
-                res[1]=(at(2)*v.at(0))-(at(0)*v.at(2));
-                res[2]=(at(0)*v.at(1))-(at(1)*v.at(0));
+                Vector<T,3> res(uninit);
+                if(std::is_constant_evaluated()) simd::Scalar<T,(N<M)?N:M>::cross(array,v.data(),res.data());
+                else simd::Kernels<T,(N<M)?N:M>::cross(array,v.data(),res.data());
                 return res;
             }
 
             // Dot product with another vector.
-            T dot(const Vector<T,N> &v) const {
-                T res=0;
-                if(is_null()||v.is_null()) return res;
-                for(int i=0;i<N;++i)
-                    res+=array[i]*v.at(i);
-                return res;
+            constexpr T dot(const Vector<T,N> &v) const {
+                if(is_null()||v.is_null()) return 0;
+                if(std::is_constant_evaluated()) return simd::Scalar<T,N>::dot(array,v.array);
+                return simd::Kernels<T,N>::dot(array,v.array);
             }
 
             //  Returns true if the vector is orthogonal to another given as an argument, false otherwise.
@@ -77,17 +111,11 @@ namespace libmatrix {
 
             // Returns true if the vector contains an invalid value, false otherwise.
             // Notably, if the vector contains nan as values.
-            bool is_null() const {
-                if (std::is_same<T, int>::value) {
-                    for(int i=0;i<N;++i) 
-                        if(array[i]==INT_MAX)
-                            return true;
-                } else {
-                    for(int i=0;i<N;++i) 
-                        if(isnan(array[i]))
-                            return true;
-                }
-                return false;
+            constexpr bool is_null() const {
+                if constexpr (std::is_same<T, int>::value)
+                    return unroll_any<N>([&](int i) { return array[i]==INT_MAX; });
+                else // nan is the only value different from itself (isnan is not constexpr).
+                    return unroll_any<N>([&](int i) { return array[i]!=array[i]; });
             }
 
             // Returns true if the vector is unit, false otherwise.
@@ -97,102 +125,117 @@ namespace libmatrix {
 
             // Returns the norm of the vector.
             T norm() const {
-                T res=0;
-                if(is_null()) return res;
-                for(int i=0;i<N;++i)
-                    res+=array[i]*array[i];
-                return sqrt(res);
+                if(is_null()) return 0;
+                return sqrt(simd::Kernels<T,N>::dot(array,array));
             }
 
             // Returns a copy of the vector normalised.
             Vector<T,N> to_unit() const {
                 Vector<T,N> res=*this;
-                T n=norm();
-                if(is_null()||n==0) return res;
-                T left = (1/n);
-                res *= left;
+                if(is_null()) return res;
+                simd::Kernels<T,N>::normalize(array,res.array);
                 return res;
             }
 
             template<typename U, int M>
             friend std::ostream &operator <<(std::ostream &out, Vector<U,M> v);
             
-            inline T &operator[](const int i) { return array[i]; }
+            constexpr T &operator[](const int i) { return array[i]; }
+            constexpr const T &operator[](const int i) const { return array[i]; }
 
-            Vector<T,N> operator+(Vector<T,N> v) {
-                Vector<T,N> res;
-                for(int i=0;i<N;++i)
-                    res[i]=array[i]+v[i];
-                return res;
+            // Named access to the first four elements (not bounds-checked at run time, unlike at).
+            constexpr T &x() { return array[0]; }
+            constexpr T &y() { static_assert(N>=2,"Vector::y : vector too small"); return array[1]; }
+            constexpr T &z() { static_assert(N>=3,"Vector::z : vector too small"); return array[2]; }
+            constexpr T &w() { static_assert(N>=4,"Vector::w : vector too small"); return array[3]; }
+            constexpr const T &x() const { return array[0]; }
+            constexpr const T &y() const { static_assert(N>=2,"Vector::y : vector too small"); return array[1]; }
+            constexpr const T &z() const { static_assert(N>=3,"Vector::z : vector too small"); return array[2]; }
+            constexpr const T &w() const { static_assert(N>=4,"Vector::w : vector too small"); return array[3]; }
+
+            // Returns a pointer to the elements of the vector, used by the SIMD kernels.
+            constexpr T *data() { return array; }
+            constexpr const T *data() const { return array; }
+
+            // Arithmetic operators return expressions (see expression.hpp), evaluated when assigned.
+            constexpr VecBinary<OpAdd,Ref,Ref,T,N> operator+(const Vector<T,N> &v) const {
+                return VecBinary<OpAdd,Ref,Ref,T,N>(Ref(array),Ref(v.array));
             }
 
-            Vector<T,N> operator+(float f) const {
-                Vector<T,N> res;
-                for(int i=0;i<N;++i)
-                    res[i]=array[i]+f;
-                return res;
+            template<typename E>
+            constexpr VecBinary<OpAdd,Ref,E,T,N> operator+(const VecExpr<E,T,N> &e) const {
+                return VecBinary<OpAdd,Ref,E,T,N>(Ref(array),e.self());
+            }
+
+            constexpr VecScalar<OpAdd,Ref,T,N> operator+(float f) const {
+                return VecScalar<OpAdd,Ref,T,N>(Ref(array),f);
             }
             
-            Vector<T,N> &operator+=(const Vector<T,N> &v) {
-                for(int i=0;i<N;++i)
-                    array[i]+=v.at(i);
+            constexpr Vector<T,N> &operator+=(const Vector<T,N> &v) {
+                unroll<N>([&](int i) { array[i]+=v.array[i]; });
+                return *this;
+            }
+
+            template<typename E>
+            constexpr Vector<T,N> &operator+=(const VecExpr<E,T,N> &e) {
+                unroll<N>([&](int i) { array[i]+=e.self()[i]; });
                 return *this;
             }
             
-            Vector<T,N> operator-(Vector<T,N> v) const {
-                Vector<T,N> res;
-                for(int i=0;i<N;++i)
-                    res[i]=array[i]-v[i];
-                return res;
+            constexpr VecBinary<OpSub,Ref,Ref,T,N> operator-(const Vector<T,N> &v) const {
+                return VecBinary<OpSub,Ref,Ref,T,N>(Ref(array),Ref(v.array));
+            }
+
+            template<typename E>
+            constexpr VecBinary<OpSub,Ref,E,T,N> operator-(const VecExpr<E,T,N> &e) const {
+                return VecBinary<OpSub,Ref,E,T,N>(Ref(array),e.self());
             }
 
-            Vector<T,N> operator-() const {
-                return *(this)*-1;
+            constexpr VecScalar<OpMul,Ref,T,N> operator-() const {
+                return VecScalar<OpMul,Ref,T,N>(Ref(array),-1);
             }
             
-            Vector<T,N> &operator-=(Vector<T,N> &v) {
-                for(int i=0;i<N;++i)
-                    array[i]-=v[i];
+            constexpr Vector<T,N> &operator-=(const Vector<T,N> &v) {
+                unroll<N>([&](int i) { array[i]-=v.array[i]; });
+                return *this;
+            }
+
+            template<typename E>
+            constexpr Vector<T,N> &operator-=(const VecExpr<E,T,N> &e) {
+                unroll<N>([&](int i) { array[i]-=e.self()[i]; });
                 return *this;
             }
             
-            Vector<T,N> operator*(T s) const {
-                Vector<T,N> res;
-                for(int i=0;i<N;++i)
-                    res[i]=array[i]*s;
-                return res;
+            constexpr VecScalar<OpMul,Ref,T,N> operator*(T s) const {
+                return VecScalar<OpMul,Ref,T,N>(Ref(array),s);
             }
             
             template<typename U, int M>
-            friend Vector<U,M> operator *(U s,const Vector<U,M> v);
+            friend constexpr VecScalar<OpMul,VecRef<U,M>,U,M> operator *(U s,const Vector<U,M> &v);
 
-            Vector<T,N> operator *(const Vector<T,N> v) const {
-                Vector<T,N> res;
-                for(int i=0;i<N;++i)
-                    res[i]=at(i)*v.at(i);
-                return res;
+            // Element-wise product.
+            constexpr VecBinary<OpMul,Ref,Ref,T,N> operator *(const Vector<T,N> &v) const {
+                return VecBinary<OpMul,Ref,Ref,T,N>(Ref(array),Ref(v.array));
             }
 
             template<int M>
             Vector<T,N> operator *(Matrix<T,N,M> m) {
-                Vector<T,N> res;
+                Vector<T,N> res(uninit);
                 for(int i=0;i<N;++i)
                     res[i]=dot(m[i]);
                 return res;
             }
             
-            Vector<T,N> &operator *=(T s) {
-                for(int i=0;i<N;++i)
-                    array[i]*=s;
+            constexpr Vector<T,N> &operator *=(T s) {
+                unroll<N>([&](int i) { array[i]*=s; });
                 return *this;
             }
 
             template<typename U, int M>
             friend Vector<U,M> &operator *=(U s,Vector<U,M> &v);
 
-            Vector<T,N> &operator *=(Vector<T,N> v) {
-                for(int i=0;i<N;++i)
-                    array[i]=array[i]*v[i];
+            constexpr Vector<T,N> &operator *=(Vector<T,N> v) {
+                unroll<N>([&](int i) { array[i]=array[i]*v[i]; });
                 return *this;
             }
             
@@ -203,24 +246,17 @@ namespace libmatrix {
                 return *this;
             }
             
-            bool operator==(const Vector<T,N> &v) const {
-                for(int i=0;i<N;++i) {
-                    if(v.at(i)!=this->at(i)) {
-                        return false;
-                    }
-                }
-                return true;
+            constexpr bool operator==(const Vector<T,N> &v) const {
+                return unroll_all<N>([&](int i) { return v.array[i]==array[i]; });
             }
 
-            bool operator!=(const Vector<T,N> &v) const {
+            constexpr bool operator!=(const Vector<T,N> &v) const {
                 return !((*this)==v);
             }
-            
-            ~Vector() {}
     };
 
     template <typename T, int N>
-    Vector<T,N> operator *(T s,const Vector<T,N> v){
+    constexpr VecScalar<OpMul,VecRef<T,N>,T,N> operator *(T s,const Vector<T,N> &v){
         return v*s;
     }
 
@@ -1,29 +1,40 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <stdlib.h>
 #include "gui.h"
 #include "scene.hpp"
 #include "object3d.hpp"
 
 int x = 0;
+bool features = false; // only the feature edges are drawn (--features)
+float crease_angle = 30; // dihedral angle (in degrees) above which an edge is drawn by --features
 
-// Opens a file in .geo format and inserts the object in the scene.
+// Opens a file in .geo format and inserts the objects in the scene. The reading stops at the end of the file, or
+// at the first value that cannot be read: the object being read is then dropped.
 void load_geo_file(const char *file, Scene &scene) {
     ifstream f(file);
-    std::string line;
     int nb,i1,i2,i3;
     float f1,f2,f3;
-    while(f.good()) {
+    while(f >> nb) {
         Object3D *o=new Object3D(x);
-        f >> nb;
-        for(int i=0;i<nb;++i) {
-            f >> f1 >> f2 >> f3;
+        for(int i=0;i<nb&&(f >> f1 >> f2 >> f3);++i)
             o->add_vertex(f1,f2,f3);
+        o->fit_bounds();
+        if(f >> nb)
+            for(int i=0;i<nb&&(f >> i1 >> i2 >> i3);++i)
+                if(!o->add_face(i1-1,i2-1,i3-1))
+                    std::cerr << file << ": face " << i+1 << " uses a missing vertex, skipped" << std::endl;
+        if(f.fail()) {
+            std::cerr << file << ": unreadable object, skipped" << std::endl;
+            delete o;
+            break;
         }
-        f >> nb;
-        for(int i=0;i<nb;++i) {
-            f >> i1 >> i2 >> i3;
-            o->add_face(i1-1,i2-1,i3-1);
+        // the feature edges are found without the hierarchy, from the table of the edges and their creases
+        if(features) o->build_creases(crease_angle);
+        else {
+            o->build_hierarchy();
+            o->build_edges();
         }
         scene.addObject3D(o);
         x=(x<=0)?(x*-1)+1:x*-1;
@@ -32,13 +43,37 @@ void load_geo_file(const char *file, Scene &scene) {
 
 // Initialises the GUI, reads the file (or files) in .geo format given as argument,
 // executes the main_loop and closes the GUI.
+// The --clip-space option clips the edges in homogeneous clip space.
+// The --features option only draws the silhouettes and the boundary and crease edges of the objects, the creases
+// being the edges whose faces make an angle above the one given by --crease-angle=<degrees> (30 by default).
 // The function must also capture eventual exceptions and treat them, if possible.
 int main(int argc, const char *argv[]) {
+    bool clip_space=false;
+    for(int i=1;i<argc;++i) {
+        std::string arg(argv[i]);
+        if(arg=="--clip-space")
+            clip_space=true;
+        else if(arg=="--features")
+            features=true;
+        else if(arg.compare(0,15,"--crease-angle=")==0) {
+            const char *value=argv[i]+15;
+            char *end;
+            crease_angle=strtof(value,&end);
+            if(end==value||*end!='\0'||!(crease_angle>=0&&crease_angle<=180)) {
+                std::cerr << "Invalid crease angle: " << value << " (expected a number of degrees between 0 and 180)" << std::endl;
+                std::cerr << "Usage: " << argv[0] << " [--clip-space] [--features] [--crease-angle=<degrees>] file.geo..." << std::endl;
+                return 1;
+            }
+        }
+    }
     gui::Gui *g = new gui::Gui();
     Camera c(g->get_win_height(),g->get_win_width());
+    c.set_clip_space(clip_space);
     Scene *scene = new Scene(g,c);
+    if(features) scene->set_edge_mode(Scene::FEATURE_EDGES);
     for(int i=1;i<argc;++i)
-        load_geo_file(argv[i],*scene);
+        if(argv[i][0]!='-')
+            load_geo_file(argv[i],*scene);
     g->start();
     g->main_loop(scene);
     g->stop();
@@ -1,6 +1,6 @@
 #include "matrix.hpp"
 
 namespace libmatrix {
-    const Mat44i Identity44i=Mat44i{0};
-    const Mat44r Identity44r=Mat44r{0};
-}
\ No newline at end of file
+    constexpr Mat44i Identity44i=Mat44i::identity();
+    constexpr Mat44r Identity44r=Mat44r::identity();
+}
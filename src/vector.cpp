@@ -1,10 +1,10 @@
 #include "vector.hpp"
 
 namespace libmatrix {
-    const Vec2i zerovec2i=Vec2i{0};
-    const Vec3i zerovec3i=Vec3i{0};
-    const Vec4i zerovec4i=Vec4i{0};
-    const Vec2r zerovec2r=Vec2r{0};
-    const Vec3r zerovec3r=Vec3r{0};
-    const Vec4r zerovec4r=Vec4r{0};
+    constexpr Vec2i zerovec2i=Vec2i{0};
+    constexpr Vec3i zerovec3i=Vec3i{0};
+    constexpr Vec4i zerovec4i=Vec4i{0};
+    constexpr Vec2r zerovec2r=Vec2r{0};
+    constexpr Vec3r zerovec3r=Vec3r{0};
+    constexpr Vec4r zerovec4r=Vec4r{0};
 }
\ No newline at end of file
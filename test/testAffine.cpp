@@ -0,0 +1,76 @@
+#include <iostream>
+#include <math.h>
+#include <assert.h>
+#include "affine.hpp"
+#include "transform.hpp"
+
+using namespace libgeometry;
+
+#define EPSYLON 0.0001
+
+bool near_equal(const Matrix<float,4,4> &m1, const Matrix<float,4,4> &m2) {
+    for(int i=0;i<4;++i)
+        for(int j=0;j<4;++j)
+            if(fabs(m1[i][j]-m2[i][j])>EPSYLON) return false;
+    return true;
+}
+
+void testApply() {
+    std::cout << "Test Apply..." << std::endl;
+    Transform<float> t=Transform<float>(Vec3r{1,-2,3}).concat(Transform<float>(40,Direction<float,4>{1,1,0}));
+    Affine3<float> a=Affine3<float>(Vec3r{1,-2,3}).concat(Affine3<float>(40,Direction<float,4>{1,1,0}));
+    Point<float,4> p{2,5,-1};
+    Direction<float,4> d{0.5,-1,2};
+    assert(a.apply(p)==t.apply(p));
+    assert(a.apply(d)==t.apply(d));
+    assert(a.apply(Point<float,4>()).is_null());
+}
+
+void testConcat() {
+    std::cout << "Test Concat..." << std::endl;
+    Affine3<float> r(30,Direction<float,4>{0,0,1}),s(Vec3r{2,2,2},true),tr(Vec3r{1,0,-4});
+    Affine3<float> a=r.concat(s).concat(tr);
+    Transform<float> t=Transform<float>(30,Direction<float,4>{0,0,1}).concat(Transform<float>(Vec3r{2,2,2},true))
+                       .concat(Transform<float>(Vec3r{1,0,-4}));
+    assert(near_equal(a.to_matrix(),t.getM()));
+    assert(a.getKind()==AFFINE);
+    assert(r.concat(tr).getKind()==RIGID);
+}
+
+void testInverse() {
+    std::cout << "Test Inverse..." << std::endl;
+    Affine3<float> rigid=Affine3<float>(Vec3r{1,2,3}).concat(Affine3<float>(75,Direction<float,4>{0,1,0}));
+    Affine3<float> affine=rigid.concat(Affine3<float>(Vec3r{1,2,0.5},true));
+    assert(near_equal(rigid.concat(rigid.inverse()).to_matrix(),Mat44r::identity()));
+    assert(near_equal(affine.concat(affine.inverse()).to_matrix(),Mat44r::identity()));
+    assert(Affine3<float>(Vec3r{0,1,1},true).inverse().getM().is_null());
+}
+
+void testProject() {
+    std::cout << "Test Project..." << std::endl;
+    Affine3<float> a=Affine3<float>(Vec3r{1,2,3}).concat(Affine3<float>(20,Direction<float,4>{1,0,0}));
+    Mat44r proj=Mat44r::perspective(1.4f,0.5f,100.f);
+    assert(near_equal(a.project(proj),proj*a.to_matrix()));
+}
+
+void testApplyMany() {
+    std::cout << "Test ApplyMany..." << std::endl;
+    Affine3<float> a=Affine3<float>(Vec3r{1,2,3}).concat(Affine3<float>(60,Direction<float,4>{0,1,1}));
+    Transform<float> t=Transform<float>(a.to_matrix());
+    Point<float,4> in[5]={{1,2,3},{-1,0,4},{0,0,0},{7,-3,2},{0.5,0.25,-8}},out[5],out4[5];
+    a.apply_many(in[0].data(),out[0].data(),5);
+    t.apply_many(in[0].data(),out4[0].data(),5);
+    for(int i=0;i<5;++i) {
+        assert(out[i]==a.apply(in[i]));
+        assert(out4[i]==out[i]);
+    }
+}
+
+int main() {
+    testApply();
+    testConcat();
+    testInverse();
+    testProject();
+    testApplyMany();
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <vector>
+#include <algorithm>
+#include "libgeometry.h"
+#include "affine.hpp"
+#include "bvh.hpp"
+#include "ray.hpp"
+#include "object3d.hpp"
+
+using namespace libgeometry;
+
+float random_float(float min, float max) {
+    return min+(rand()/(float)RAND_MAX)*(max-min);
+}
+
+std::vector<AABB<float>> random_boxes(int n) {
+    std::vector<AABB<float>> boxes(n);
+    for(int i=0;i<n;++i) {
+        Vec3r c{random_float(-100,100),random_float(-100,100),random_float(-100,100)};
+        float s=random_float(0.1,2);
+        boxes[i]=AABB<float>(Vec3r{c[0]-s,c[1]-s,c[2]-s},Vec3r{c[0]+s,c[1]+s,c[2]+s});
+    }
+    return boxes;
+}
+
+bool overlap(const AABB<float> &b1, const AABB<float> &b2) {
+    for(int i=0;i<3;++i)
+        if(b1.get_high()[i]<b2.get_low()[i]||b2.get_high()[i]<b1.get_low()[i]) return false;
+    return true;
+}
+
+// Returns the primitives whose boxes overlap the query box, found through the hierarchy.
+std::vector<uint32_t> query(const BVH<float> &bvh, const std::vector<AABB<float>> &boxes, const AABB<float> &q) {
+    std::vector<uint32_t> res;
+    bvh.traverse(0,[&](uint32_t, const AABB<float> &box, int &) {
+        if(!overlap(box,q)) return DISJOINT;
+        return q.contains(box)?CONTAINED:OVERLAPPING;
+    },[&](uint32_t p) {
+        // the primitives of the leaves overlapping the query are visited without being tested
+        if(overlap(boxes[p],q)) res.push_back(p);
+    });
+    std::sort(res.begin(),res.end());
+    return res;
+}
+
+// Checks that every primitive is in exactly one leaf, and that the boxes of the nodes contain their content.
+void check(const BVH<float> &bvh, const std::vector<AABB<float>> &boxes) {
+    std::vector<int> seen(boxes.size(),0);
+    for(size_t i=0;i<bvh.size();++i) {
+        const BVH<float>::Node &n=bvh.get_node(i);
+        if(n.is_leaf()) {
+            for(uint32_t p=n.offset;p<n.offset+n.count;++p) {
+                ++seen[bvh.primitive(p)];
+                assert(n.box.contains(boxes[bvh.primitive(p)]));
+            }
+        } else {
+            assert(n.offset>i&&n.offset+1<bvh.size());
+            assert(n.box.contains(bvh.get_node(n.offset).box));
+            assert(n.box.contains(bvh.get_node(n.offset+1).box));
+        }
+    }
+    for(size_t i=0;i<boxes.size();++i)
+        assert(seen[i]==1);
+}
+
+void testBox() {
+    std::cout << "Test Box..." << std::endl;
+    AABB<float> b;
+    assert(b.is_empty()&&b.surface_area()==0);
+    b.grow(Vec3r{1,2,3});
+    b.grow(Vec3r{-1,0,5});
+    assert(b.get_low()==(Vec3r{-1,0,3})&&b.get_high()==(Vec3r{1,2,5}));
+    assert(b.center()==(Vec3r{0,1,4})&&b.extents()==(Vec3r{1,1,1}));
+    assert(b.surface_area()==24);
+    assert(b.contains(AABB<float>(Vec3r{0,1,4},Vec3r{1,1,4})));
+    // the box of the transform contains the transforms of the corners
+    Affine3<float> a=Affine3<float>(Vec3r{1,2,3}).concat(Affine3<float>(30,Direction<float,4>{0,1,0}));
+    AABB<float> t=a.apply(b);
+    for(int i=0;i<8;++i) {
+        Point<float,4> p=a.apply(Point<float,4>{(i&1)?1.f:-1.f,(i&2)?2.f:0.f,(i&4)?5.f:3.f});
+        assert(t.get_low()[0]<=p.x()+0.0001f&&t.get_high()[0]>=p.x()-0.0001f);
+        assert(t.get_low()[2]<=p.z()+0.0001f&&t.get_high()[2]>=p.z()-0.0001f);
+    }
+}
+
+void testBuild() {
+    std::cout << "Test Build..." << std::endl;
+    std::vector<AABB<float>> boxes=random_boxes(1000);
+    BVH<float> bvh;
+    bvh.build(boxes.data(),boxes.size(),1);
+    check(bvh,boxes);
+    assert(bvh.size()<2*boxes.size());
+    // a box per primitive, and the same primitives several times at the same place
+    std::vector<AABB<float>> same(50,AABB<float>(Vec3r{0,0,0},Vec3r{1,1,1}));
+    bvh.build(same.data(),same.size(),1);
+    check(bvh,same);
+    bvh.build(boxes.data(),1,1);
+    assert(bvh.size()==1&&bvh.get_node(0).count==1);
+    bvh.build(boxes.data(),0);
+    assert(bvh.size()==0);
+    // empty boxes (objects without vertex) are kept out of the binning, in a leaf of their own
+    std::vector<AABB<float>> mixed=random_boxes(2000);
+    for(size_t i=0;i<mixed.size();i+=7)
+        mixed[i]=AABB<float>();
+    bvh.build(mixed.data(),mixed.size(),4);
+    check(bvh,mixed);
+    AABB<float> q(Vec3r{-50,-50,-50},Vec3r{50,50,50});
+    std::vector<uint32_t> expected;
+    for(size_t i=0;i<mixed.size();++i)
+        if(overlap(mixed[i],q)) expected.push_back(i);
+    assert(!expected.empty()&&query(bvh,mixed,q)==expected);
+    std::vector<AABB<float>> empty(3);
+    bvh.build(empty.data(),empty.size());
+    check(bvh,empty);
+    assert(bvh.size()==1&&bvh.get_node(0).count==3);
+}
+
+void testQuery() {
+    std::cout << "Test Query..." << std::endl;
+    std::vector<AABB<float>> boxes=random_boxes(20000);
+    BVH<float> serial,parallel;
+    serial.build(boxes.data(),boxes.size(),1);
+    parallel.build(boxes.data(),boxes.size(),4);
+    check(parallel,boxes);
+    for(int q=0;q<20;++q) {
+        Vec3r c{random_float(-100,100),random_float(-100,100),random_float(-100,100)};
+        AABB<float> box(Vec3r{c[0]-10,c[1]-10,c[2]-10},Vec3r{c[0]+10,c[1]+10,c[2]+10});
+        std::vector<uint32_t> expected;
+        for(size_t i=0;i<boxes.size();++i)
+            if(overlap(boxes[i],box)) expected.push_back(i);
+        assert(query(serial,boxes,box)==expected);
+        assert(query(parallel,boxes,box)==expected);
+    }
+}
+
+void testRefit() {
+    std::cout << "Test Refit..." << std::endl;
+    std::vector<AABB<float>> boxes=random_boxes(500);
+    BVH<float> bvh;
+    bvh.build(boxes.data(),boxes.size());
+    for(size_t i=0;i<boxes.size();i+=3) {
+        Vec3r low=boxes[i].get_low(),high=boxes[i].get_high();
+        for(int k=0;k<3;++k) {
+            low[k]+=50;
+            high[k]+=50;
+        }
+        boxes[i]=AABB<float>(low,high);
+    }
+    bvh.refit(boxes.data());
+    check(bvh,boxes);
+    AABB<float> box(Vec3r{40,40,40},Vec3r{100,100,100});
+    std::vector<uint32_t> expected;
+    for(size_t i=0;i<boxes.size();++i)
+        if(overlap(boxes[i],box)) expected.push_back(i);
+    assert(query(bvh,boxes,box)==expected);
+}
+
+void testRay() {
+    std::cout << "Test Ray..." << std::endl;
+    Triangle<float,4> tr(Point<float,4>{0,0,0},Point<float,4>{2,0,0},Point<float,4>{0,2,0});
+    float t=-1;
+    assert(Ray<float>(Vec3r{0.5f,0.5f,-3},Vec3r{0,0,2}).hits(tr,t)&&t==1.5f);
+    assert(Ray<float>(Vec3r{0.5f,0.5f,3},Vec3r{0,0,-1}).hits(tr,t)&&t==3);
+    assert(!Ray<float>(Vec3r{0.5f,0.5f,3},Vec3r{0,0,1}).hits(tr,t)); // behind the origin
+    assert(!Ray<float>(Vec3r{1.5f,1.5f,-3},Vec3r{0,0,1}).hits(tr,t)); // beside the triangle
+    assert(!Ray<float>(Vec3r{0,0,-3},Vec3r{1,0,0}).hits(tr,t)); // parallel
+    assert(!Ray<float>(Vec3r{0.5f,0.5f,-3},Vec3r{0,0,1}).hits(Triangle<float,4>(),t));
+    AABB<float> b(Vec3r{-1,-1,-1},Vec3r{1,1,1});
+    Ray<float> r(Vec3r{-5,0,0},Vec3r{1,0,0});
+    assert(r.hits(b,10)&&!r.hits(b,3)&&r.hits(b,4));
+    assert(!Ray<float>(Vec3r{-5,2,0},Vec3r{1,0,0}).hits(b,10));
+    assert(Ray<float>(Vec3r{0,0,0},Vec3r{0,1,0}).hits(b,0)); // starting inside
+    assert(!Ray<float>(Vec3r{-5,0,0},Vec3r{-1,0,0}).hits(b,10));
+}
+
+void testMesh() {
+    std::cout << "Test Mesh..." << std::endl;
+    // grid of 40x40 cells in the plane z=0, bent upwards along x
+    Object3D o;
+    for(int i=0;i<=40;++i)
+        for(int j=0;j<=40;++j)
+            o.add_vertex(i,j,i*i*0.01f);
+    for(int i=0;i<40;++i)
+        for(int j=0;j<40;++j) {
+            unsigned int v=i*41+j;
+            o.add_face(v,v+41,v+1);
+            o.add_face(v+1,v+41,v+42);
+        }
+    assert(o.get_hierarchy().size()==0);
+    std::vector<Ray<float>> rays;
+    for(int k=0;k<200;++k)
+        rays.push_back(Ray<float>(Vec3r{random_float(-5,45),random_float(-5,45),30},
+                                  Vec3r{random_float(-0.3f,0.3f),random_float(-0.3f,0.3f),-1}));
+    std::vector<float> ts;
+    std::vector<unsigned int> faces;
+    for(size_t k=0;k<rays.size();++k) {
+        float t=-1;
+        unsigned int f=0;
+        if(!o.raycast(rays[k],t,f)) t=-1;
+        ts.push_back(t);
+        faces.push_back(f);
+    }
+    o.build_hierarchy();
+    assert(o.get_hierarchy().size()>0&&o.get_hierarchy().get_node(0).box.contains(o.bbox()));
+    int hits=0;
+    for(size_t k=0;k<rays.size();++k) {
+        float t=-1;
+        unsigned int f=0;
+        bool hit=o.raycast(rays[k],t,f);
+        assert(hit==(ts[k]>=0));
+        if(hit) {
+            ++hits;
+            assert(t==ts[k]&&o.face(f).get_p0()==o.face(faces[k]).get_p0());
+        }
+    }
+    assert(hits>50&&hits<200);
+    o.add_face(0,1,2);
+    assert(o.get_hierarchy().size()==0);
+}
+
+int main() {
+    testBox();
+    testBuild();
+    testQuery();
+    testRefit();
+    testRay();
+    testMesh();
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <iostream>
+#include <math.h>
+#include <assert.h>
+#include "libgeometry.h"
+#include "camera.hpp"
+
+using namespace libgeometry;
+
+#define EPSYLON 0.0001
+
+// Returns the segment between two points of world space, transformed by the camera and clipped.
+LineSegment<float,4> visible(const Camera &c, const Point<float,4> &p1, const Point<float,4> &p2) {
+    Transform<float> t=c.get_transform();
+    return c.visible_part(LineSegment<float,4>(t.apply(p1),t.apply(p2)));
+}
+
+// Returns true if two points give the same point of the image once divided by w.
+bool same_image(const Point<float,4> &p1, const Point<float,4> &p2) {
+    return fabs(p1.x()/p1.w()-p2.x()/p2.w())<EPSYLON&&fabs(p1.y()/p1.w()-p2.y()/p2.w())<EPSYLON;
+}
+
+void testClipSpace() {
+    std::cout << "Test ClipSpace..." << std::endl;
+    // the default camera is at z=-1 and looks towards +z
+    Camera view(600,800),clip(600,800);
+    clip.set_clip_space(true);
+    view.update();
+    clip.update();
+    // in front of the camera: drawn in both modes, at the same place of the image, with w>0 in clip space
+    Point<float,4> p1{0,0,10},p2{2,1,20};
+    LineSegment<float,4> v=visible(view,p1,p2),c=visible(clip,p1,p2);
+    assert(!v.is_null()&&!c.is_null());
+    assert(c.get_begin().w()>0&&c.get_end().w()>0);
+    assert(same_image(v.get_begin(),c.get_begin())&&same_image(v.get_end(),c.get_end()));
+    // crossing a side: clipped by the view planes, left to the line drawer in clip space
+    c=visible(clip,Point<float,4>{0,0,10},Point<float,4>{20,0,10});
+    assert(!c.is_null()&&c.get_end().w()>0);
+    assert(!visible(view,Point<float,4>{0,0,10},Point<float,4>{20,0,10}).is_null());
+    // behind the camera: dropped in both modes
+    assert(visible(view,Point<float,4>{0,0,-10},Point<float,4>{1,1,-20}).is_null());
+    assert(visible(clip,Point<float,4>{0,0,-10},Point<float,4>{1,1,-20}).is_null());
+    // crossing the near plane: the end behind the camera is cut at z=-w
+    c=visible(clip,Point<float,4>{0,0,10},Point<float,4>{0,0,-10});
+    assert(!c.is_null()&&c.get_begin().w()>0);
+    assert(fabs(c.get_end().z()+c.get_end().w())<EPSYLON);
+}
+
+int main() {
+    testClipSpace();
+    return 0;
+}
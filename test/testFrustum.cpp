@@ -0,0 +1,216 @@
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "libgeometry.h"
+#include "frustum.hpp"
+
+using namespace libgeometry;
+
+#define EPSYLON 0.0001
+
+// Field of vision of 90 degrees, looking towards -z.
+Frustum make_frustum() {
+    Frustum f(100.f,0.5f,1.f);
+    f.update(1);
+    return f;
+}
+
+bool near_equal(const Point<float,4> &p1, const Point<float,4> &p2) {
+    for(int i=0;i<4;++i)
+        if(fabs(p1[i]-p2[i])>EPSYLON) return false;
+    return true;
+}
+
+void testOutcode() {
+    std::cout << "Test Outcode..." << std::endl;
+    Frustum f=make_frustum();
+    typedef Valid<Point<float,4>> VP;
+    assert(f.outcode(VP(Point<float,4>{0,0,-5}))==0);
+    assert(f.outcode(VP(Point<float,4>{0,0,-0.1}))==1u<<Frustum::NEAR_PLANE);
+    assert(f.outcode(VP(Point<float,4>{0,0,-200}))==1u<<Frustum::FAR_PLANE);
+    assert(f.outcode(VP(Point<float,4>{-10,0,-5}))==1u<<Frustum::LEFT_PLANE);
+    assert(f.outcode(VP(Point<float,4>{10,10,-5}))==((1u<<Frustum::RIGHT_PLANE)|(1u<<Frustum::TOP_PLANE)));
+    assert(f.outside(Point<float,4>{0,-10,-5}));
+    assert(!f.outside(Point<float,4>{0,0,-5}));
+    assert(f.outside(Point<float,4>()));
+}
+
+void testInter() {
+    std::cout << "Test Inter..." << std::endl;
+    Frustum f=make_frustum();
+    // both inside: unchanged
+    LineSegment<float,4> ls(Point<float,4>{-1,0,-5},Point<float,4>{1,1,-10});
+    LineSegment<float,4> res=f.inter(ls);
+    assert(res.get_begin()==ls.get_begin()&&res.get_end()==ls.get_end());
+    // one end inside: clipped on the left plane, the inside end kept
+    res=f.inter(LineSegment<float,4>(Point<float,4>{0,0,-5},Point<float,4>{-10,0,-5}));
+    assert(res.get_begin()==(Point<float,4>{0,0,-5}));
+    assert(near_equal(res.get_end(),Point<float,4>{-5,0,-5}));
+    res=f.inter(LineSegment<float,4>(Point<float,4>{-10,0,-5},Point<float,4>{0,0,-5}));
+    assert(near_equal(res.get_begin(),Point<float,4>{-5,0,-5}));
+    assert(res.get_end()==(Point<float,4>{0,0,-5}));
+    // both ends outside, crossing the field of vision
+    res=f.inter(LineSegment<float,4>(Point<float,4>{-10,0,-5},Point<float,4>{10,0,-5}));
+    assert(near_equal(res.get_begin(),Point<float,4>{-5,0,-5}));
+    assert(near_equal(res.get_end(),Point<float,4>{5,0,-5}));
+    // both ends behind the same plane
+    assert(f.inter(LineSegment<float,4>(Point<float,4>{-10,0,-5},Point<float,4>{-10,1,-6})).is_null());
+    // both ends outside different planes, passing next to a corner
+    assert(f.inter(LineSegment<float,4>(Point<float,4>{-10,1,-5},Point<float,4>{1,10,-5})).is_null());
+    // one end outside two planes, clipped by the one hit last
+    res=f.inter(LineSegment<float,4>(Point<float,4>{0,0,-5},Point<float,4>{-10,-20,-5}));
+    assert(near_equal(res.get_end(),Point<float,4>{-2.5,-5,-5}));
+    // ends with w!=1 (built from vectors, the lists setting w to 1): the clipped end is interpolated on all four
+    // coordinates, and is (-5,0,-5) once divided by w
+    Point<float,4> b(Vector<float,4>{0,0,-10,2}),e(Vector<float,4>{-20,0,-10,2});
+    res=f.inter(LineSegment<float,4>(b,e));
+    assert(res.get_begin()==b);
+    assert(near_equal(res.get_end(),Point<float,4>(Vector<float,4>{-10,0,-10,2})));
+    e=Point<float,4>(Vector<float,4>{-30,0,-15,3});
+    res=f.inter(LineSegment<float,4>(b,e));
+    assert(near_equal(res.get_end(),Point<float,4>(Vector<float,4>{-12,0,-12,2.4f})));
+    assert(f.inter(LineSegment<float,4>()).is_null());
+}
+
+void testClipSpace() {
+    std::cout << "Test ClipSpace..." << std::endl;
+    Transform<float> proj(Mat44r::perspective(1,0.5,100));
+    // inside, and crossing only a side plane: unchanged
+    LineSegment<float,4> ls(proj.apply(Point<float,4>{0,0,-5}),proj.apply(Point<float,4>{-10,0,-5}));
+    assert(Frustum::clip_outcode(ls.get_end())==1u<<Frustum::LEFT_PLANE);
+    LineSegment<float,4> res=Frustum::clip_homogeneous(ls);
+    assert(res.get_begin()==ls.get_begin()&&res.get_end()==ls.get_end());
+    // crossing the near plane: clipped at z=-w, the end behind the camera removed
+    ls=LineSegment<float,4>(proj.apply(Point<float,4>{0,0,-5}),proj.apply(Point<float,4>{0,0,5}));
+    res=Frustum::clip_homogeneous(ls);
+    assert(res.get_begin()==ls.get_begin());
+    assert(fabs(res.get_end().z()+res.get_end().w())<EPSYLON);
+    assert(fabs(res.get_end().w()-0.5)<EPSYLON);
+    // beyond the far plane
+    ls=LineSegment<float,4>(proj.apply(Point<float,4>{0,0,-200}),proj.apply(Point<float,4>{1,0,-300}));
+    assert(Frustum::clip_homogeneous(ls).is_null());
+    // far beyond a side: clipped at the guard band
+    ls=LineSegment<float,4>(proj.apply(Point<float,4>{0,0,-5}),proj.apply(Point<float,4>{-1000,0,-5}));
+    res=Frustum::clip_homogeneous(ls);
+    assert(fabs(res.get_end().x()/res.get_end().w()+Frustum::guard_band)<EPSYLON);
+    assert(Frustum::clip_homogeneous(LineSegment<float,4>()).is_null());
+}
+
+void testClassify() {
+    std::cout << "Test Classify..." << std::endl;
+    Frustum f=make_frustum();
+    assert(f.classify(Sphere<float,4>(Point<float,4>{0,0,-10},1))==Frustum::INSIDE);
+    assert(f.classify(Sphere<float,4>(Point<float,4>{10,0,-10},1))==Frustum::INTERSECTING);
+    assert(f.classify(Sphere<float,4>(Point<float,4>{20,0,-10},1))==Frustum::OUTSIDE);
+    assert(f.classify(Sphere<float,4>())==Frustum::OUTSIDE);
+    Point<float,4> inside[3]={Point<float,4>{0,0,-5},Point<float,4>{1,1,-5},Point<float,4>{-1,0,-8}};
+    assert(f.classify(inside,3)==Frustum::INSIDE);
+    Point<float,4> crossing[3]={Point<float,4>{0,0,-5},Point<float,4>{-10,0,-5},Point<float,4>{-1,0,-8}};
+    assert(f.classify(crossing,3)==Frustum::INTERSECTING);
+    Point<float,4> outside[3]={Point<float,4>{-10,0,-5},Point<float,4>{-20,10,-5},Point<float,4>{-20,0,-8}};
+    assert(f.classify(outside,3)==Frustum::OUTSIDE);
+    // outside different planes: the segments may cross the field of vision
+    Point<float,4> corners[2]={Point<float,4>{-10,0,-5},Point<float,4>{10,0,-5}};
+    assert(f.classify(corners,2)==Frustum::INTERSECTING);
+    Transform<float> proj(Mat44r::perspective(1,0.5,100));
+    for(int i=0;i<3;++i) {
+        inside[i]=proj.apply(inside[i]);
+        outside[i]=proj.apply(outside[i]);
+    }
+    assert(Frustum::classify_clip_space(inside,3)==Frustum::INSIDE);
+    assert(Frustum::classify_clip_space(outside,3)==Frustum::OUTSIDE);
+}
+
+void testCoherence() {
+    std::cout << "Test Coherence..." << std::endl;
+    Frustum f=make_frustum();
+    Frustum::CullStats stats;
+    Sphere<float,4> left(Point<float,4>{-20,0,-10},1);
+    unsigned char last=0;
+    unsigned int mask=Frustum::ALL_PLANES;
+    assert(f.classify(left,mask,last,&stats)==Frustum::OUTSIDE);
+    assert(last==Frustum::LEFT_PLANE);
+    assert(stats.plane_tests==3);
+    // the next frame, the left plane is tested first
+    mask=Frustum::ALL_PLANES;
+    assert(f.classify(left,mask,last,&stats)==Frustum::OUTSIDE);
+    assert(stats.plane_tests==4&&stats.volumes==2);
+    assert(stats.average()==2);
+    // the planes a parent is completely in front of are not tested for its children
+    Sphere<float,4> parent(Point<float,4>{0,0,-10},8),child(Point<float,4>{-9,0,-10},1);
+    mask=Frustum::ALL_PLANES;
+    stats.reset();
+    assert(f.classify(parent,mask,last,&stats)==Frustum::INTERSECTING);
+    assert(mask==((1u<<Frustum::LEFT_PLANE)|(1u<<Frustum::RIGHT_PLANE)|(1u<<Frustum::BOTTOM_PLANE)|(1u<<Frustum::TOP_PLANE)));
+    unsigned int child_mask=mask;
+    assert(f.classify(child,child_mask,last,&stats)==Frustum::INTERSECTING);
+    assert(stats.plane_tests==6+4);
+    assert(child_mask==(1u<<Frustum::LEFT_PLANE));
+    // the same answers as without the masks
+    Sphere<float,4> spheres[3]={left,parent,Sphere<float,4>(Point<float,4>{0,0,-10},1)};
+    for(int i=0;i<3;++i) {
+        mask=Frustum::ALL_PLANES;
+        last=Frustum::TOP_PLANE;
+        assert(f.classify(spheres[i],mask,last)==f.classify(spheres[i]));
+    }
+}
+
+float random_float(float min, float max) {
+    return min+(rand()/(float)RAND_MAX)*(max-min);
+}
+
+// Checks that the batch tests give the same answers as outside, at every SIMD level.
+void testBatch() {
+    std::cout << "Test Batch..." << std::endl;
+    const int n=203; // not a multiple of the number of lanes
+    Frustum f=make_frustum();
+    float in[7][n];
+    for(int i=0;i<n;++i) {
+        for(int k=0;k<3;++k)
+            in[k][i]=random_float(-20,20);
+        in[2][i]-=20;
+        for(int k=3;k<7;++k)
+            in[k][i]=random_float(0,5);
+    }
+    in[0][7]=NAN; // null center
+    simd::Level best=simd::supported();
+    for(int l=simd::SCALAR;l<=best;++l) {
+        simd::set_level((simd::Level)l);
+        uint32_t spheres[(n+31)/32],inside[(n+31)/32],boxes[(n+31)/32];
+        f.visible_spheres(in[0],in[1],in[2],in[3],n,spheres,inside);
+        f.visible_boxes(in[0],in[1],in[2],in[4],in[5],in[6],n,boxes);
+        int count=0;
+        for(int i=0;i<n;++i) {
+            Point<float,4> c{in[0][i],in[1][i],in[2][i]};
+            bool sphere=(spheres[i/32]>>(i%32))&1,box=(boxes[i/32]>>(i%32))&1;
+            assert(sphere==!f.outside(Sphere<float,4>(c,in[3][i])));
+            assert(((inside[i/32]>>(i%32))&1)==(f.classify(Sphere<float,4>(c,in[3][i]))==Frustum::INSIDE));
+            assert(box==!f.outside(c,Vec3r{in[4][i],in[5][i],in[6][i]}));
+            count+=sphere;
+        }
+        assert(!(spheres[0]&(1u<<7)));
+        assert(count>0&&count<n);
+    }
+    simd::set_level(best);
+}
+
+void testSegment() {
+    std::cout << "Test Segment..." << std::endl;
+    LineSegment<float,4> ls(Point<float,4>{0,0,0},Point<float,4>{0,0,-4});
+    Plane<float,4> p(Vector<float,4>{0,0,-1,-1});
+    assert(ls.inter(p)==(Point<float,4>{0,0,-1}));
+    assert(ls.inter(Plane<float,4>(Vector<float,4>{0,0,-1,-5})).is_null());
+    assert(ls.inter(Plane<float,4>(Vector<float,4>{0,0,-1,1})).is_null());
+}
+
+int main() {
+    testOutcode();
+    testInter();
+    testClipSpace();
+    testClassify();
+    testCoherence();
+    testBatch();
+    testSegment();
+    return 0;
+}
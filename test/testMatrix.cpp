@@ -2,10 +2,12 @@
 #include "vector.hpp"
 #include <iostream>
 #include <assert.h>
+#include <math.h>
 
 using namespace libmatrix;
 
 #define SIZE 10
+#define EPSYLON 0.0001
 
 void testAt() {
     std::cout << "Test At..." << std::endl;
@@ -34,6 +36,32 @@ void testInverse() {
     std::cout << inv << std::endl;
 }
 
+// Returns true if the product of the two matrices is the identity, up to EPSYLON.
+bool is_identity_product(Matrix<float,4,4> m1, Matrix<float,4,4> m2) {
+    Matrix<float,4,4> p=m1*m2;
+    for(int i=0;i<4;++i)
+        for(int j=0;j<4;++j)
+            if(fabs(p[i][j]-(i==j?1:0))>EPSYLON) return false;
+    return true;
+}
+
+void testInverse44() {
+    std::cout << "Test Inverse44..." << std::endl;
+    // rotation of 90 degrees around z, then translation
+    Matrix<float,4,4> rigid{0,-1,0,3,1,0,0,-2,0,0,1,5,0,0,0,1};
+    Matrix<float,4,4> affine{2,1,0,3,0,3,1,-2,1,0,4,5,0,0,0,1};
+    Matrix<float,4,4> proj{2,0,1,0,0,3,0,1,0,0,-1,-2,0,0,-1,0};
+    Matrix<float,4,4> singular{1,2,3,4,2,4,6,8,0,0,1,0,0,0,0,1};
+    assert(is_identity_product(rigid,rigid.inverse_rigid()));
+    assert(is_identity_product(rigid,rigid.inverse_affine()));
+    assert(is_identity_product(affine,affine.inverse_affine()));
+    assert(is_identity_product(affine,affine.inverse_cofactor()));
+    assert(is_identity_product(proj,proj.inverse_cofactor()));
+    assert(is_identity_product(proj,proj.inverse()));
+    assert(singular.inverse_affine().is_null());
+    assert(singular.inverse_cofactor().is_null());
+}
+
 void testIsNull() {
     std::cout << "Test IsNull..." << std::endl;
     Matrix<float,2,2> m1{1,2,3,4},m2;
@@ -41,6 +69,20 @@ void testIsNull() {
     assert(m2.is_null());
 } 
 
+void testTags() {
+    std::cout << "Test Tags..." << std::endl;
+    Mat44r z(zero);
+    assert(!z.is_null()&&z==Mat44r{0});
+    Matrix<float,2,3> u(uninit);
+    for(int i=0;i<2;++i)
+        for(int j=0;j<3;++j)
+            u[i][j]=i*3+j;
+    assert((u==Matrix<float,2,3>{0,1,2,3,4,5}));
+    // results that cannot be null do not depend on the initial values
+    Mat44r id=Mat44r::identity();
+    assert(!id.is_null()&&!(id*id).is_null()&&!id.transpose().is_null());
+}
+
 void testIsOrtho() {
     std::cout << "Test IsOrtho..." << std::endl;
     Matrix<float,3,3> m1{0,1,0,0,0,1,1,0,0},m2{1,2,3,4,5,6,7,8,9};
@@ -69,6 +111,7 @@ void testOperators() {
     Matrix<float,2,2> m4 = m1*m2;
     assert(m3==m4);
     Matrix<float,2,3> m5=m1;
+    assert(m5==m1&&m5[1][2]==6);
     std::cout << m3 << std::endl;
     Matrix<float,2,2> mx{1,2,3,4};
     Matrix<float,2,2> mx2;
@@ -79,14 +122,37 @@ void testOperators() {
     assert(mx2[1][1]==8);
     mx*=2;
     assert(mx==mx2);
+    Matrix<float,2,2> my{1,1,1,1},mz=(mx+my)*0.5f-my;
+    assert(mz==(Matrix<float,2,2>{0.5,1.5,2.5,3.5}));
+    mz+=2.f*my;
+    assert(mz==(Matrix<float,2,2>{2.5,3.5,4.5,5.5}));
+}
+
+void testConstexpr() {
+    std::cout << "Test Constexpr..." << std::endl;
+    constexpr Mat44r id=Mat44r::identity();
+    static_assert(id[0][0]==1&&id[3][3]==1&&id[0][1]==0&&id[3][0]==0);
+    constexpr Mat44r proj=Mat44r::perspective(2,1,3);
+    static_assert(proj[0][0]==2&&proj[1][1]==2&&proj[2][2]==-2&&proj[2][3]==-3&&proj[3][2]==-1&&proj[3][3]==0);
+    constexpr Mat44r m{1,2,0,1, 0,1,0,2, 0,0,1,3, 0,0,0,1};
+    static_assert(m*id==m&&m.inverse_affine()*m==id);
+    static_assert(Mat44r(m+id)[0][0]==2&&Mat44r(m*2.f)[2][3]==6);
+    constexpr Vec4r v=m*Vec4r{1,1,1,1};
+    static_assert(v==Vec4r{4,3,4,1});
+    static_assert(Mat44r().is_null()&&!id.is_null());
+    Mat44r runtime=m;
+    assert(runtime*runtime.inverse_affine()==id);
 }
 
 int main() {
     testAt();
     testInverse();
+    testInverse44();
     testIsNull();
+    testTags();
     testIsOrtho();
     testTranspose();
     testOperators();
+    testConstexpr();
 	return 0;
 }
\ No newline at end of file
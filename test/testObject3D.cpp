@@ -0,0 +1,336 @@
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <vector>
+#include <algorithm>
+#include "libgeometry.h"
+#include "object3d.hpp"
+
+using namespace libgeometry;
+
+float random_float(float min, float max) {
+    return min+(rand()/(float)RAND_MAX)*(max-min);
+}
+
+// Returns true if the sphere given as argument contains every vertex.
+bool contains_vertices(const Sphere<float,4> &s, const std::vector<Point<float,4>> &vertices) {
+    for(size_t i=0;i<vertices.size();++i)
+        if(s.getCenter().length_to(vertices[i]).norm()>s.getRadius()*1.0001f) return false;
+    return true;
+}
+
+void testBounds() {
+    std::cout << "Test Bounds..." << std::endl;
+    Object3D o;
+    assert(o.bbox().is_empty()&&o.local_bsphere().is_null()&&o.bsphere().is_null());
+    std::vector<Point<float,4>> vertices;
+    for(int i=0;i<1000;++i) {
+        Point<float,4> p{random_float(10,14),random_float(-1,1),random_float(-2,2)};
+        vertices.push_back(p);
+        o.add_vertex(p.x(),p.y(),p.z());
+        // the volumes grow with each vertex
+        assert(o.bbox().contains(AABB<float>(Vec3r{p.x(),p.y(),p.z()},Vec3r{p.x(),p.y(),p.z()})));
+        assert(contains_vertices(o.local_bsphere(),vertices));
+    }
+    float grown=o.local_bsphere().getRadius();
+    AABB<float> box=o.bbox();
+    o.fit_bounds();
+    assert(o.bbox().get_low()==box.get_low()&&o.bbox().get_high()==box.get_high());
+    assert(contains_vertices(o.local_bsphere(),vertices));
+    assert(o.local_bsphere().getRadius()<=grown);
+    // around the geometry, not the position of the object: about the half diagonal of the box
+    Vector<float,3> e=o.bbox().extents();
+    assert(o.local_bsphere().getRadius()<=sqrt(e.dot(e))*1.05f);
+    assert(fabs(o.local_bsphere().getCenter().x()-12)<0.5f);
+    // sphere circumscribed around the corners of a cube, and inscribed in the box of an octahedron
+    Object3D cube,octahedron;
+    for(int i=0;i<8;++i)
+        cube.add_vertex(i&1,(i>>1)&1,(i>>2)&1);
+    cube.fit_bounds();
+    assert(fabs(cube.sphere_tightness()-sqrt(3)*M_PI/2)<0.001f);
+    for(int k=0;k<3;++k)
+        for(int s=-1;s<=1;s+=2)
+            octahedron.add_vertex((k==0)?s:0,(k==1)?s:0,(k==2)?s:0);
+    octahedron.fit_bounds();
+    assert(fabs(octahedron.sphere_tightness()-M_PI/6)<0.001f);
+    // in world space, moved and scaled with the object
+    o.set_position(1,2,3);
+    o.set_scale(2);
+    Sphere<float,4> world=o.bsphere();
+    assert(world.getRadius()==2*o.local_bsphere().getRadius());
+    assert(fabs(world.getCenter().x()-(2*o.local_bsphere().getCenter().x()+1))<0.0001f);
+    // the world box contains the transformed vertices, and is cut by the sphere when the object is rotated
+    o.set_rotation(Quaternion<float>(45,Direction<float,4>{1,1,1}.to_unit()));
+    box=o.world_bbox();
+    assert(o.getAffine().apply(o.bbox()).contains(box));
+    assert(box.surface_area()<o.getAffine().apply(o.bbox()).surface_area());
+    for(size_t i=0;i<vertices.size();++i) {
+        Point<float,4> p=o.getAffine().apply(vertices[i]);
+        for(int k=0;k<3;++k)
+            assert(box.get_low()[k]<=p[k]+0.001f&&box.get_high()[k]>=p[k]-0.001f);
+    }
+    // removing the vertex the farthest along x shrinks the box
+    size_t far=0;
+    for(size_t i=0;i<vertices.size();++i)
+        if(vertices[i].x()>vertices[far].x()) far=i;
+    o.remove_vertex(far);
+    vertices.erase(vertices.begin()+far);
+    float max=vertices[0].x();
+    for(size_t i=0;i<vertices.size();++i)
+        if(vertices[i].x()>max) max=vertices[i].x();
+    assert(o.bbox().get_high()[0]==max);
+    assert(contains_vertices(o.local_bsphere(),vertices));
+    // the version changes when the object moves or its bounds change, not when its matrix is read
+    unsigned long version=o.get_version();
+    o.getAffine();
+    o.bsphere();
+    o.world_bbox();
+    assert(o.get_version()==version);
+    o.set_position(0,0,1);
+    assert(o.get_version()!=version);
+    version=o.get_version();
+    o.getAffine();
+    o.set_rotation(Quaternion<float>(10,Direction<float,4>{0,1,0}));
+    assert(o.get_version()!=version);
+    version=o.get_version();
+    o.add_vertex(100,0,0);
+    assert(o.get_version()!=version);
+}
+
+void testIndices() {
+    std::cout << "Test Indices..." << std::endl;
+    Object3D o;
+    for(int i=0;i<4;++i)
+        o.add_vertex(i,i*i,0);
+    assert(o.add_face(0,1,2));
+    o.add_face(1,2,3);
+    o.add_face(0,2,3);
+    assert(o.num_faces()==3&&o.num_vertices()==4);
+    // a face using a vertex that does not exist is not added
+    assert(!o.add_face(0,1,4)&&!o.add_face(70000,0,1));
+    assert(o.num_faces()==3&&o.mesh_bytes()==4*3*sizeof(float)+9*sizeof(uint16_t)+3*4*sizeof(float));
+    // the coordinates are stored one array per axis, on a cache line boundary
+    for(int k=0;k<3;++k)
+        assert((uintptr_t)o.get_coords(k)%64==0);
+    assert(o.get_coords(1)[3]==9&&o.vertex(3)==(Point<float,4>{3,9,0}));
+    assert(o.mesh_bytes()==4*3*sizeof(float)+9*sizeof(uint16_t)+3*4*sizeof(float));
+    // the faces share their vertices
+    assert(o.index(1,0)==1&&o.index(2,2)==3);
+    assert(o.face(1).get_p2()==(Point<float,4>{3,9,0}));
+    assert(o.face(3).is_null());
+    // the faces using a removed vertex go with it, the others refer to the vertices after it one place lower
+    o.remove_vertex(1);
+    assert(o.num_faces()==1&&o.num_vertices()==3);
+    assert(o.index(0,0)==0&&o.index(0,1)==1&&o.index(0,2)==2);
+    assert(o.face(0).get_p1()==(Point<float,4>{2,4,0}));
+    o.remove_face(0);
+    assert(o.num_faces()==0);
+    // the indices go on 32 bits when the vertices no longer fit on 16
+    Object3D big;
+    for(int i=0;i<70000;++i)
+        big.add_vertex(i,0,0);
+    big.add_face(0,1,2);
+    assert(big.mesh_bytes()==70000*3*sizeof(float)+3*sizeof(uint16_t)+4*sizeof(float));
+    big.add_face(1,65536,69999);
+    assert(big.mesh_bytes()==70000*3*sizeof(float)+6*sizeof(uint32_t)+2*4*sizeof(float));
+    assert(big.index(0,2)==2&&big.index(1,1)==65536&&big.face(1).get_p2().x()==69999);
+}
+
+void testPlanes() {
+    std::cout << "Test Planes..." << std::endl;
+    // tetrahedron whose faces are wound as in the .geo files, their normales pointing inside
+    Object3D o;
+    o.add_vertex(0,0,0);
+    o.add_vertex(1,0,0);
+    o.add_vertex(0,1,0);
+    o.add_vertex(0,0,1);
+    o.add_face(0,1,2);
+    o.add_face(0,3,1);
+    o.add_face(0,2,3);
+    o.add_face(1,3,2);
+    assert(o.mesh_bytes()==4*3*sizeof(float)+12*sizeof(uint16_t)+4*4*sizeof(float));
+    Point<float,4> inside{0.1f,0.1f,0.1f};
+    for(unsigned int f=0;f<o.num_faces();++f) {
+        Plane<float,4> p=o.plane(f);
+        Triangle<float,4> t=o.face(f);
+        Direction<float,4> n=t.normale();
+        for(int k=0;k<3;++k)
+            assert(fabs(p[k]-n[k])<0.0001f);
+        assert(fabs(t.get_p0().dot(p))<0.0001f&&fabs(t.get_p2().dot(p))<0.0001f);
+        assert(inside.dot(p)>0);
+        assert(!o.faces(f,Vec3r{0.1f,0.1f,0.1f}));
+    }
+    // from below, only the face z=0 is seen, and from far along the diagonal only the slanted one
+    assert(o.faces(0,Vec3r{0.2f,0.2f,-5})&&!o.faces(1,Vec3r{0.2f,0.2f,-5})&&!o.faces(3,Vec3r{0.2f,0.2f,-5}));
+    assert(o.faces(3,Vec3r{5,5,5})&&!o.faces(0,Vec3r{5,5,5})&&!o.faces(1,Vec3r{5,5,5})&&!o.faces(2,Vec3r{5,5,5}));
+    // the planes follow the faces when some are removed
+    o.remove_face(0);
+    assert(o.faces(2,Vec3r{5,5,5})&&!o.faces(0,Vec3r{5,5,5}));
+    o.remove_vertex(2);
+    assert(o.num_faces()==1&&o.faces(0,Vec3r{0.2f,-5,0.2f})&&!o.faces(0,Vec3r{0.2f,5,0.2f}));
+    // a degenerate face faces nothing
+    o.add_face(0,1,1);
+    assert(!o.faces(1,Vec3r{0.2f,-5,0.2f})&&!o.faces(1,Vec3r{0.2f,5,0.2f}));
+}
+
+// Checks that the k-th edge of each face joins its k-th vertex to the next, and lists the face.
+void check_edges(const Object3D &o) {
+    for(unsigned int f=0;f<o.num_faces();++f)
+        for(int k=0;k<3;++k) {
+            const Object3D::Edge &e=o.get_edges()[o.edge(f,k)];
+            uint32_t v0=o.index(f,k),v1=o.index(f,(k+1)%3);
+            assert((e.v0==v0&&e.v1==v1)||(e.v0==v1&&e.v1==v0));
+            assert(e.v0<=e.v1);
+            assert(e.faces[0]==f||e.faces[1]==f);
+        }
+}
+
+void testEdges() {
+    std::cout << "Test Edges..." << std::endl;
+    // closed tetrahedron: 6 edges, each shared by 2 faces
+    Object3D o;
+    o.add_vertex(0,0,0);
+    o.add_vertex(1,0,0);
+    o.add_vertex(0,1,0);
+    o.add_vertex(0,0,1);
+    o.add_face(0,1,2);
+    o.add_face(0,3,1);
+    o.add_face(0,2,3);
+    o.add_face(1,3,2);
+    assert(o.get_edges().empty());
+    o.build_edges();
+    assert(o.get_edges().size()==6);
+    for(size_t i=0;i<o.get_edges().size();++i)
+        assert(o.get_edges()[i].faces[1]!=Object3D::NO_FACE);
+    check_edges(o);
+    assert(o.edge(0,0)==o.edge(1,2)); // edge 0-1
+    // an edge of three faces is split into two entries
+    o.add_vertex(1,1,-1);
+    o.add_face(0,1,4);
+    assert(o.get_edges().empty());
+    o.build_edges();
+    assert(o.get_edges().size()==9);
+    check_edges(o);
+    assert(o.edge(4,0)!=o.edge(0,0)&&o.get_edges()[o.edge(4,0)].faces[1]==Object3D::NO_FACE);
+    // open grid of 10x10 cells: 40 boundary edges
+    Object3D grid;
+    for(int i=0;i<=10;++i)
+        for(int j=0;j<=10;++j)
+            grid.add_vertex(i,j,0);
+    for(int i=0;i<10;++i)
+        for(int j=0;j<10;++j) {
+            unsigned int v=i*11+j;
+            grid.add_face(v,v+11,v+1);
+            grid.add_face(v+1,v+11,v+12);
+        }
+    grid.build_edges();
+    check_edges(grid);
+    size_t boundary=0;
+    for(size_t i=0;i<grid.get_edges().size();++i)
+        boundary+=grid.get_edges()[i].faces[1]==Object3D::NO_FACE;
+    assert(grid.get_edges().size()==320&&boundary==40);
+    // every edge of the faces selected is visited once
+    std::vector<uint32_t> selected;
+    for(uint32_t f=0;f<grid.num_faces();f+=3)
+        selected.push_back(f);
+    selected.push_back(1);
+    std::vector<unsigned char> flags;
+    std::vector<std::pair<uint32_t,uint32_t>> visited,expected;
+    grid.visit_edges(selected.data(),selected.size(),flags,[&](uint32_t v0, uint32_t v1) {
+        visited.push_back({v0,v1});
+    });
+    for(size_t i=0;i<selected.size();++i)
+        for(int k=0;k<3;++k) {
+            const Object3D::Edge &e=grid.get_edges()[grid.edge(selected[i],k)];
+            expected.push_back({e.v0,e.v1});
+        }
+    std::sort(visited.begin(),visited.end());
+    std::sort(expected.begin(),expected.end());
+    expected.erase(std::unique(expected.begin(),expected.end()),expected.end());
+    assert(visited==expected&&visited.size()<3*selected.size());
+    for(size_t i=0;i<flags.size();++i)
+        assert(flags[i]==0);
+}
+
+void testFeatures() {
+    std::cout << "Test Features..." << std::endl;
+    // the edges of the tetrahedron are all creases, and only the ones of the face seen are drawn
+    Object3D o;
+    o.add_vertex(0,0,0);
+    o.add_vertex(1,0,0);
+    o.add_vertex(0,1,0);
+    o.add_vertex(0,0,1);
+    o.add_face(0,1,2);
+    o.add_face(0,3,1);
+    o.add_face(0,2,3);
+    o.add_face(1,3,2);
+    assert(!o.has_creases());
+    o.build_creases(30);
+    assert(o.has_creases()&&o.get_edges().size()==6&&o.num_creases()==6);
+    std::vector<uint32_t> out;
+    o.feature_edges(Vec3r{5,5,5},out);
+    std::vector<uint32_t> expected{o.edge(3,0),o.edge(3,1),o.edge(3,2)};
+    std::sort(out.begin(),out.end());
+    std::sort(expected.begin(),expected.end());
+    assert(out==expected);
+    o.feature_edges(Vec3r{0.1f,0.1f,0.1f},out);
+    assert(out.empty());
+    // without creases, only the silhouette is left
+    o.build_creases(179);
+    assert(o.num_creases()==0);
+    o.feature_edges(Vec3r{5,5,5},out);
+    std::sort(out.begin(),out.end());
+    assert(out==expected);
+    o.feature_edges(Vec3r{0.2f,0.2f,-5},out);
+    assert(out.size()==3);
+    // changing the faces drops the marks
+    o.add_face(0,1,3);
+    assert(!o.has_creases());
+    // flat grid: only its boundary, and only from the side it faces
+    Object3D grid;
+    for(int i=0;i<=10;++i)
+        for(int j=0;j<=10;++j)
+            grid.add_vertex(i,j,0);
+    for(int i=0;i<10;++i)
+        for(int j=0;j<10;++j) {
+            unsigned int v=i*11+j;
+            grid.add_face(v,v+11,v+1);
+            grid.add_face(v+1,v+11,v+12);
+        }
+    grid.build_creases(30);
+    assert(grid.num_creases()==40);
+    grid.feature_edges(Vec3r{5,5,-5},out);
+    assert(out.size()==40);
+    for(size_t i=0;i<out.size();++i)
+        assert(grid.get_edges()[out[i]].faces[1]==Object3D::NO_FACE);
+    grid.feature_edges(Vec3r{5,5,5},out);
+    assert(out.empty());
+    // wavy grid large enough to be split between threads: the result does not depend on their number
+    Object3D wave;
+    const int size=300;
+    for(int i=0;i<=size;++i)
+        for(int j=0;j<=size;++j)
+            wave.add_vertex(i,j,2*sinf(i*0.3f)*cosf(j*0.2f));
+    for(int i=0;i<size;++i)
+        for(int j=0;j<size;++j) {
+            unsigned int v=i*(size+1)+j;
+            wave.add_face(v,v+size+1,v+1);
+            wave.add_face(v+1,v+size+1,v+size+2);
+        }
+    wave.build_creases(30);
+    assert(wave.get_edges().size()>=4*Object3D::MIN_PARALLEL_EDGES);
+    std::vector<uint32_t> single,many;
+    wave.feature_edges(Vec3r{-50,-30,40},single,1);
+    wave.feature_edges(Vec3r{-50,-30,40},many,4);
+    assert(!single.empty()&&single.size()<wave.get_edges().size()/4&&single==many);
+}
+
+int main() {
+    testBounds();
+    testIndices();
+    testPlanes();
+    testEdges();
+    testFeatures();
+    return 0;
+}
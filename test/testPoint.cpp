@@ -14,6 +14,17 @@ void testBehind() {
     assert(p3.behind(pl));
 }
 
+void testPlane() {
+    std::cout << "Test Plane..." << std::endl;
+    Plane<float,4> pl(Vector<float,4>{0,3,4,10});
+    assert(pl==(Vector<float,4>{0,0.6f,0.8f,2}));
+    // without normal, the plane is null instead of NaN (or a division by zero for integers)
+    Plane<float,4> degenerate(Vector<float,4>{0,0,0,5});
+    assert(degenerate==(Vector<float,4>{0,0,0,0}));
+    Plane<int,4> degenerate_int(Vector<int,4>{0,0,0,5});
+    assert(degenerate_int==(Vector<int,4>{0,0,0,0}));
+}
+
 void testLengthTo() {
     std::cout << "Test LengthTo..." << std::endl;
     Point<float,4> p1{10,15,3}, p2{2,8,16};
@@ -71,6 +82,7 @@ void testTriangleArea() {
 
 int main() {
     testBehind();
+    testPlane();
     testLengthTo();
     testOutside();
     testRotate();
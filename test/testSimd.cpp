@@ -0,0 +1,78 @@
+#include "matrix.hpp"
+#include "vector.hpp"
+#include "simd.hpp"
+#include <iostream>
+#include <stdlib.h>
+#include <assert.h>
+
+using namespace libmatrix;
+
+#define SIZE 100
+
+float random_float() {
+    return (rand()%2000)/100.f-10;
+}
+
+Vec4r random_vector() {
+    return Vec4r{random_float(),random_float(),random_float(),random_float()};
+}
+
+Mat44r random_matrix() {
+    Mat44r m;
+    for(int i=0;i<4;++i)
+        m[i]=random_vector();
+    return m;
+}
+
+// Checks that every level supported by the CPU gives the same results as the scalar kernels.
+void testLevels() {
+    std::cout << "Test Levels..." << std::endl;
+    simd::Level best=simd::supported();
+    for(int n=0;n<SIZE;++n) {
+        Vec4r v1=random_vector(),v2=random_vector();
+        Mat44r m1=random_matrix(),m2=random_matrix();
+        simd::set_level(simd::SCALAR);
+        float dot=v1.dot(v2);
+        Vec3r cross=v1.cross(v2);
+        Vec4r unit=v1.to_unit(),mv=m1*v1;
+        Mat44r mm=m1*m2;
+        // 7 points stored as one array per coordinate, transformed into interleaved points
+        float coords[3][7],aos[28],res[28];
+        for(int k=0;k<3;++k)
+            for(int p=0;p<7;++p)
+                coords[k][p]=random_float();
+        const float *rows[4]={m1[0].data(),m1[1].data(),m1[2].data(),m1[3].data()};
+        const float *in[3]={coords[0],coords[1],coords[2]};
+        simd::Kernels<float,4>::transform_soa_to_aos(rows,in,aos,7);
+        for(int l=simd::SSE2;l<=best;++l) {
+            simd::set_level((simd::Level)l);
+            assert(simd::level()==l);
+            assert(v1.dot(v2)==dot);
+            assert(v1.cross(v2)==cross);
+            assert(v1.to_unit()==unit);
+            assert(m1*v1==mv);
+            assert(m1*m2==mm);
+            simd::Kernels<float,4>::transform_soa_to_aos(rows,in,res,7);
+            assert(!memcmp(res,aos,sizeof(aos)));
+        }
+    }
+    simd::set_level(best);
+}
+
+void testNull() {
+    std::cout << "Test Null..." << std::endl;
+    Vec4r v1{1,2,3,4},v2,zero{0};
+    Mat44r m{1,2,3,4,1,2,3,4,1,2,3,4,1,2,3,4};
+    assert(v1.dot(v2)==0);
+    assert(v2.to_unit().is_null());
+    assert(zero.to_unit()==zero);
+    Vec4r res=m*v2;
+    for(int i=0;i<4;++i)
+        assert(res[i]==0);
+}
+
+int main() {
+    testLevels();
+    testNull();
+    return 0;
+}
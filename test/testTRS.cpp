@@ -0,0 +1,71 @@
+#include <iostream>
+#include <math.h>
+#include <assert.h>
+#include "trs.hpp"
+
+using namespace libgeometry;
+
+#define EPSYLON 0.0001
+
+bool near_equal(const Matrix<float,4,4> &m1, const Matrix<float,4,4> &m2) {
+    for(int i=0;i<4;++i)
+        for(int j=0;j<4;++j)
+            if(fabs(m1[i][j]-m2[i][j])>EPSYLON) return false;
+    return true;
+}
+
+void testAffine() {
+    std::cout << "Test Affine..." << std::endl;
+    Quaternion<float> q(50,Direction<float,4>{0,1,0});
+    TRS<float> t(Vec3r{1,2,3},q,2);
+    Transform<float> expected=Transform<float>(Vec3r{2,2,2},true).concat(Transform<float>(q))
+                              .concat(Transform<float>(Vec3r{1,2,3}));
+    assert(near_equal(t.affine().to_matrix(),expected.getM()));
+    assert(t.affine().getKind()==AFFINE);
+    // a translation alone gives the same matrix as Transform
+    TRS<float> tr(Vec3r{1,2,3});
+    assert(tr.transform().getM()==Transform<float>(Vec3r{1,2,3}).getM());
+    assert(tr.transform().getKind()==RIGID);
+    // a rotation given unnormalised is normalised, so that the rigid inverse holds
+    TRS<float> r(Vec3r{1,2,3},Quaternion<float>{0,0,1,1});
+    Point<float,4> p=r.affine().apply(Point<float,4>{1,0,0});
+    Point<float,4> back=r.affine().inverse().apply(p);
+    assert(r.affine().getKind()==RIGID);
+    assert(fabs(p.x()-1)<EPSYLON&&fabs(p.y()-3)<EPSYLON&&fabs(p.z()-3)<EPSYLON);
+    assert(fabs(back.x()-1)<EPSYLON&&fabs(back.y())<EPSYLON&&fabs(back.z())<EPSYLON);
+}
+
+void testCache() {
+    std::cout << "Test Cache..." << std::endl;
+    TRS<float> t(Vec3r{1,2,3});
+    assert(t.is_dirty());
+    t.affine();
+    assert(!t.is_dirty());
+    t.affine();
+    assert(!t.is_dirty());
+    t.set_translation(Vec3r{0,0,1});
+    assert(t.is_dirty());
+    assert(t.affine().apply(Point<float,4>{1,1,1})==(Point<float,4>{1,1,2}));
+    t.set_scale(3);
+    assert(t.is_dirty());
+    assert(t.affine().apply(Point<float,4>{1,1,1})==(Point<float,4>{3,3,4}));
+    t.set_rotation(Quaternion<float>{0,0,0,2});
+    assert(t.get_rotation()==(Quaternion<float>{0,0,0,1}));
+}
+
+void testConcat() {
+    std::cout << "Test Concat..." << std::endl;
+    TRS<float> t1(Vec3r{1,-2,0.5},Quaternion<float>(30,Direction<float,4>{1,0,0}),2);
+    TRS<float> t2(Vec3r{-3,1,2},Quaternion<float>(70,Direction<float,4>{0,0,1}),0.5);
+    TRS<float> c=t1.concat(t2);
+    assert(c.is_dirty());
+    assert(near_equal(c.affine().to_matrix(),t1.affine().concat(t2.affine()).to_matrix()));
+    assert(c.get_scale()==1);
+}
+
+int main() {
+    testAffine();
+    testCache();
+    testConcat();
+    return 0;
+}
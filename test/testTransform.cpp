@@ -86,11 +86,75 @@ void testApplySphere() {
     std::cout << res4 << std::endl;
 }
 
+void testApplyMany() {
+    std::cout << "Test ApplyMany..." << std::endl;
+    Transform<float> t=Transform<float>(Vector<float,3>{10,-2,3},false).concat(Transform<float>(30,Direction<float,4>{2,1,4}));
+    Point<float,4> points[5]={Point<float,4>{1,2,3},Point<float,4>{-4,5,6},Point<float,4>{0,0,0},
+                              Point<float,4>{7,-8,9},Point<float,4>{0.5,0.25,-1}},res[5];
+    t.apply_many(points[0].data(),res[0].data(),5);
+    for(int i=0;i<5;++i)
+        assert(res[i]==t.apply(points[i]));
+    float x[5],y[5],z[5],ox[5],oy[5],oz[5],ow[5];
+    for(int i=0;i<5;++i) {
+        x[i]=points[i][0];
+        y[i]=points[i][1];
+        z[i]=points[i][2];
+    }
+    t.apply_many(x,y,z,ox,oy,oz,ow,5);
+    for(int i=0;i<5;++i)
+        assert(ox[i]==res[i][0]&&oy[i]==res[i][1]&&oz[i]==res[i][2]&&ow[i]==res[i][3]);
+    Point<float,4> interleaved[5];
+    t.apply_many(x,y,z,interleaved[0].data(),5);
+    for(int i=0;i<5;++i)
+        assert(interleaved[i][0]==ox[i]&&interleaved[i][1]==oy[i]&&interleaved[i][2]==oz[i]&&interleaved[i][3]==ow[i]);
+    t.apply_many(points[0].data(),points[0].data(),5);
+    for(int i=0;i<5;++i)
+        assert(points[i]==res[i]);
+}
+
+void testInverse() {
+    std::cout << "Test Inverse..." << std::endl;
+    Point<float,4> p{1,2,3};
+    Transform<float> t1(Vector<float,3>{10,-2,3},false);
+    Transform<float> t2(Quaternion<float>(30,Direction<float,4>{0,1,0}));
+    Transform<float> t3(Vector<float,3>{2,2,4},true);
+    Transform<float> rigid=t1.concat(t2),affine=rigid.concat(t3);
+    assert(rigid.getKind()==RIGID);
+    assert(affine.getKind()==AFFINE);
+    Transform<float> proj(Matrix<float,4,4>{2,0,1,0,0,3,0,1,0,0,-1,-2,0,0,-1,0});
+    assert(proj.getKind()==PROJECTIVE);
+    Transform<float> ts[3]={rigid,affine,affine.concat(proj)};
+    for(int i=0;i<3;++i) {
+        Point<float,4> res=ts[i].inverse().apply(ts[i].apply(p));
+        for(int j=0;j<3;++j)
+            assert(fabs(res[j]/res[3]-p[j])<EPSYLON);
+    }
+}
+
+void testConstexpr() {
+    std::cout << "Test Constexpr..." << std::endl;
+    constexpr Transform<float> rotation(90,Direction<float,4>{0,0,1});
+    static_assert(rotation.getKind()==RIGID);
+    constexpr Point<float,4> p=rotation.apply(Point<float,4>{1,0,0});
+    static_assert(constmath::abs(p[0])<EPSYLON&&constmath::abs(p[1]-1)<EPSYLON&&p[2]==0&&p[3]==1);
+    constexpr Transform<float> view=Transform<float>(Vec3r{1,2,3}).concat(rotation).inverse();
+    static_assert(view.getKind()==RIGID);
+    // Same values as the rotation computed at run time.
+    float angle=90;
+    Transform<float> t(angle,Direction<float,4>{0,0,1});
+    for(int i=0;i<4;++i)
+        for(int j=0;j<4;++j)
+            assert(fabs(t.getM()[i][j]-rotation.getM()[i][j])<1e-6);
+}
+
 int main() {
     testToQuat();
     testConcat();
     testApplyPoint();
     testApplyDirection();
     testApplySphere();
+    testApplyMany();
+    testInverse();
+    testConstexpr();
 }
 
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <assert.h>
+#include "libmatrix.h"
+#include "libgeometry.h"
+#include "valid.hpp"
+
+using namespace libgeometry;
+
+void testDot() {
+    std::cout << "Test Dot..." << std::endl;
+    Vec4r v1{1,2,3,4},v2{-2,0.5,3,1};
+    Valid<Vec4r> f1(v1);
+    assert(f1.dot(v2)==v1.dot(v2));
+    assert(f1.norm()==v1.norm());
+}
+
+void testCross() {
+    std::cout << "Test Cross..." << std::endl;
+    Vec4r v1{1,2,3,4},v2{-2,0.5,3,1};
+    Valid<Vec4r> f1(v1);
+    assert(f1.cross(v2)==v1.cross(v2));
+    Valid<Vec3r> f3(Vec3r{0,0,0});
+    assert(f3.cross(Vec3r{1,2,3})==(Vec3r{0,0,0}));
+}
+
+void testToUnit() {
+    std::cout << "Test ToUnit..." << std::endl;
+    Direction<float,4> d{3,4,12};
+    Valid<Direction<float,4>> f(d);
+    assert(f.to_unit()==d.to_unit());
+    // a null norm leaves the vector unchanged, like Vector::to_unit
+    Valid<Vec3r> z(Vec3r{0,0,0});
+    assert(z.to_unit()==(Vec3r{0,0,0}));
+}
+
+void testBehind() {
+    std::cout << "Test Behind..." << std::endl;
+    Point<float,4> p1{10,-5,4},p3{-3,-8,3};
+    Plane<float,4> pl(Vector<float,4>{1,2,3,4});
+    Valid<Point<float,4>> f1(p1),f3(p3);
+    assert(!f1.behind(pl));
+    assert(f3.behind(pl));
+    assert(f1.distance(pl)>0);
+}
+
+void testApply() {
+    std::cout << "Test Apply..." << std::endl;
+    Transform<float> t=Transform<float>(Vec3r{1,2,3}).concat(Transform<float>(30,Direction<float,4>{0,1,0}));
+    Point<float,4> p{1,-2,5};
+    Valid<Point<float,4>> f(p);
+    assert(t.apply(f)==t.apply(p));
+}
+
+int main() {
+    testDot();
+    testCross();
+    testToUnit();
+    testBehind();
+    testApply();
+    return 0;
+}
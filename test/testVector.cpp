@@ -84,6 +84,29 @@ void testIsNull() {
     assert(v2i.is_null());
 }
 
+void testNamedAccess() {
+    std::cout << "Test NamedAccess..." << std::endl;
+    Vec4r v{1,2,3,4};
+    assert(v.x()==1&&v.y()==2&&v.z()==3&&v.w()==4);
+    v.z()=7;
+    assert(v[2]==7);
+    constexpr Vec2i c{5,6};
+    static_assert(c.x()==5&&c.y()==6);
+    static_assert(alignof(Vec4r)==16&&alignof(Vec2r)==8&&sizeof(Vec3r)==3*sizeof(float));
+}
+
+void testTags() {
+    std::cout << "Test Tags..." << std::endl;
+    Vec3r z(zero);
+    Vec4i zi(zero);
+    assert(z==(Vec3r{0,0,0})&&!z.is_null());
+    assert(zi==(Vec4i{0,0,0,0})&&!zi.is_null());
+    Vec4r u(uninit);
+    for(int i=0;i<4;++i)
+        u[i]=i;
+    assert(u==(Vec4r{0,1,2,3}));
+}
+
 void testIsUnit() {
     std::cout << "Test IsUnit..." << std::endl;
     Vec2r v1{3,2},v2;
@@ -144,15 +167,36 @@ void testOperators() {
     assert(!(eq1!=eq2));
 }
 
+void testExpressions() {
+    std::cout << "Test Expressions..." << std::endl;
+    Vec4r a{1,2,3,4},b{-1,0.5,2,8},c{3,3,3,3};
+    Vec4r res=a+b*2.f-c;
+    for(int i=0;i<4;++i)
+        assert(res[i]==a[i]+b[i]*2-c[i]);
+    res=-(a-b)+2.f*c;
+    for(int i=0;i<4;++i)
+        assert(res[i]==-(a[i]-b[i])+2*c[i]);
+    // the destination can be an operand
+    a=a*2.f+b;
+    assert(a==(Vec4r{1,4.5,8,16}));
+    a+=b-c;
+    assert(a==(Vec4r{-3,2,7,21}));
+    Vec4r p=a*b;
+    assert(p==(Vec4r{3,1,14,168}));
+}
+
 int main() {
 	testAt();
     testCross();
     testDot();
     testIsOrtho();
     testIsNull();
+    testTags();
+    testNamedAccess();
     testIsUnit();
     testNorm();
     testToUnit();
     testOperators();
+    testExpressions();
 	return 0;
 }